@@ -0,0 +1,2 @@
+Bench_LIBS := proteos debugger navigation
+Bench_LDFLAGS := -u _printf_float -u _scanf_float
\ No newline at end of file
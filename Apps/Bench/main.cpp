@@ -0,0 +1,217 @@
+// Measures how long the firmware calls used in control loops take, so changes to Libs can be
+//   judged with numbers instead of guesses. Run "runBenchmarks()" from ProteOS; each result
+//   is shown in nanoseconds per call and appended to BENCH_FILE. Results that don't fit on the
+//   screen can be seen by touching "Log" afterwards.
+//
+// Each primitive is called many times in a row and timed with the DWT cycle counter. The
+//   cost of the loop and the call itself, measured with an empty function, is subtracted.
+//   Interrupts (the ticker, the firmware's own timers) still run, so results are slightly
+//   pessimistic and vary by a few percent between runs.
+
+#include "proteos.hpp"
+#include "cycles.hpp"
+#include "format.hpp"
+#include "navigation.hpp"
+#include "spsc.hpp"
+
+#include "math.h"
+#include "stdarg.h"
+#include "stdio.h"
+
+#include "FEHIO.h"
+#include "FEHLCD.h"
+#include "FEHRPS.h"
+#include "FEHSD.h"
+#include "FEHUtility.h"
+
+// Results are appended, so runs before and after a change can be compared
+#define BENCH_FILE "BENCH.TXT"
+
+// Iterations for calls that take microseconds, and for calls that take milliseconds
+#define FAST_ITERATIONS 10000
+#define SLOW_ITERATIONS 200
+
+struct Benchmark {
+    const char* name;
+    void (*op)();
+    int iterations;
+    uint32_t nsPerCall;
+};
+
+AnalogInputPin analogPin(FEHIO::P0_0);
+
+static FEHFile* scratchFile;
+static volatile float floatSink;
+static volatile int intSink;
+static char textSink[32];
+
+// The size of what the ticker hands to the main loop in practice
+struct BenchPose {
+    float x;
+    float y;
+    float heading;
+};
+
+static SpscQueue<uint32_t, 16> benchQueue;
+static LatestValue<BenchPose> benchPose;
+
+void runBenchmarks();
+
+static void emptyOp() {}
+
+static void timeNowOp() {
+    floatSink = (float) TimeNow();
+}
+
+static void countsOp() {
+    intSink = Motors::lEncoder.Counts();
+}
+
+static void rpsXOp() {
+    floatSink = RPS.X();
+}
+
+static void touchOp() {
+    float x, y;
+    intSink = LCD.Touch(&x, &y);
+}
+
+static void writeRCOp() {
+    LCD.WriteRC("Bench", 12, 0);
+}
+
+static void analogValueOp() {
+    floatSink = analogPin.Value();
+}
+
+static void fprintfOp() {
+    SD.FPrintf(scratchFile, "%i %f\n", 1234, 5.678f);
+}
+
+static void cosOp() {
+    floatSink = cos(floatSink + 0.5f);
+}
+
+static void sinOp() {
+    floatSink = sin(floatSink + 0.5f);
+}
+
+static void formatText(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(textSink, sizeof(textSink), format, args);
+    va_end(args);
+}
+
+static void vsnprintfOp() {
+    formatText("%i %f", 1234, 5.678f);
+}
+
+// The same text as vsnprintfOp(), for comparing the two
+static void formatPrintOp() {
+    Format::print(textSink, sizeof(textSink), "%i %f", 1234, 5.678f);
+}
+
+static void spscOp() {
+    uint32_t item;
+    benchQueue.push(1234);
+    benchQueue.pop(&item);
+    intSink = (int) item;
+}
+
+static void latestValueOp() {
+    BenchPose pose = { 1.0f, 2.0f, 3.0f };
+    benchPose.write(pose);
+    benchPose.read(&pose);
+    floatSink = pose.heading;
+}
+
+static Benchmark benchmarks[] = {
+    { "TimeNow()", &timeNowOp, FAST_ITERATIONS, 0 },
+    { "Counts()", &countsOp, FAST_ITERATIONS, 0 },
+    { "RPS.X()", &rpsXOp, FAST_ITERATIONS, 0 },
+    { "LCD.Touch()", &touchOp, SLOW_ITERATIONS, 0 },
+    { "LCD.WriteRC()", &writeRCOp, SLOW_ITERATIONS, 0 },
+    { "Value()", &analogValueOp, FAST_ITERATIONS, 0 },
+    { "SD.FPrintf()", &fprintfOp, SLOW_ITERATIONS, 0 },
+    { "cos()", &cosOp, FAST_ITERATIONS, 0 },
+    { "sin()", &sinOp, FAST_ITERATIONS, 0 },
+    { "vsnprintf()", &vsnprintfOp, FAST_ITERATIONS, 0 },
+    { "Format::print()", &formatPrintOp, FAST_ITERATIONS, 0 },
+    { "SPSC push+pop", &spscOp, FAST_ITERATIONS, 0 },
+    { "Latest wr+rd", &latestValueOp, FAST_ITERATIONS, 0 },
+};
+static const int benchmarkCount = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+
+static constexpr ProteOSFunction functions[] = {
+    { "runBenchmarks()", &runBenchmarks },
+};
+
+int main() {
+    ProteOS::setFunctions(functions);
+
+    ProteOS::run();
+}
+
+// Total cycles taken by calling op iterations times
+static uint64_t timeCalls(void (*op)(), int iterations) {
+    uint32_t start = CycleCounter::now();
+    for (int i = 0; i < iterations; i++) {
+        (*op)();
+    }
+    return CycleCounter::now() - start;
+}
+
+static uint32_t cyclesToNs(uint64_t cycles) {
+    return (uint32_t) (cycles * 1000000000ull / CORE_CLOCK_HZ);
+}
+
+void runBenchmarks() {
+    CycleCounter::start();
+
+    scratchFile = SD.FOpen("BENCHTMP.TXT", "w");
+    if (scratchFile == NULL) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printLine(0, "SD card not available");
+        Debugger::setFontColor();
+        return;
+    }
+
+    // What the loop and the function pointer call cost on their own
+    uint64_t overheadCycles = timeCalls(&emptyOp, FAST_ITERATIONS);
+
+    for (int i = 0; i < benchmarkCount; i++) {
+        Benchmark& b = benchmarks[i];
+        // The top line shows progress, so results fill the screen from the line below it
+        Debugger::printLine(0, "Timing %s", b.name);
+        Debugger::abortCheck();
+
+        uint64_t cycles = timeCalls(b.op, b.iterations);
+        uint64_t overhead = overheadCycles * (uint64_t) b.iterations / FAST_ITERATIONS;
+        cycles = cycles > overhead ? cycles - overhead : 0;
+        b.nsPerCall = cyclesToNs(cycles / (uint64_t) b.iterations);
+
+        Debugger::printNextLine("%-14s %lu ns", b.name, (unsigned long) b.nsPerCall);
+    }
+
+    SD.FClose(scratchFile);
+
+    FEHFile* file = SD.FOpen(BENCH_FILE, "a");
+    if (file == NULL) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printLine(0, "Results not saved");
+        Debugger::setFontColor();
+        return;
+    }
+    SD.FPrintf(file, "BENCH %lu Hz, %lu ns loop overhead\n", (unsigned long) CORE_CLOCK_HZ,
+               (unsigned long) cyclesToNs(overheadCycles / FAST_ITERATIONS));
+    for (int i = 0; i < benchmarkCount; i++) {
+        SD.FPrintf(file, "%s %lu %i\n", benchmarks[i].name, (unsigned long) benchmarks[i].nsPerCall,
+                   benchmarks[i].iterations);
+    }
+    SD.FPrintf(file, "\n");
+    SD.FClose(file);
+
+    Debugger::printLine(0, "Saved to %s", BENCH_FILE);
+}
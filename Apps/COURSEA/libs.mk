@@ -1 +1 @@
-COURSEA_LIBS := proteos debugger navigation
\ No newline at end of file
+COURSEA_LIBS := proteos crashdump debugger navigation pcsampler sampler loopmonitor meminfo profiler startlight telemetry timeline tracelog uartstream
\ No newline at end of file
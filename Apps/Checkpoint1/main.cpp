@@ -27,17 +27,25 @@ float lsThreshold = 2.f;
 
 // Function definitions
 
+static constexpr ProteOSVariable variables[] = {
+    { "distanceToBackUp", &distanceToBackUp },
+    { "lsThreshold", &lsThreshold },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "motorTest()", &motorTest },
+    { "encoderTest()", &encoderTest },
+    { "waitForLight()", &waitForLight },
+    { "goToKiosk()", &goToKiosk },
+    { "backDownTheRamp()", &backDownTheRamp },
+    { "navigate()", &navigate },
+    { "runSection()", &runSection },
+};
+
 int main() {
-    ProteOS::registerVariable("distanceToBackUp", &distanceToBackUp);
-    ProteOS::registerVariable("lsThreshold", &lsThreshold);
-
-    ProteOS::registerFunction("motorTest()", &motorTest);
-    ProteOS::registerFunction("encoderTest()", &encoderTest);
-    ProteOS::registerFunction("waitForLight()", &waitForLight);
-    ProteOS::registerFunction("goToKiosk()", &goToKiosk);
-    ProteOS::registerFunction("backDownTheRamp()", &backDownTheRamp);
-    ProteOS::registerFunction("navigate()", &navigate);
-    ProteOS::registerFunction("runSection()", &runSection);
+    ProteOS::setAppName("Checkpoint1");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 }
@@ -32,20 +32,28 @@ void whatcolorisit();
 void comehome();
 
 
+static constexpr ProteOSVariable variables[] = {
+    { "redthreshold", &redthreshold },
+    { "bluethreshold", &bluethreshold },
+    { "rampDistance", &rampDistance },
+    { "kioskDistance", &kioskDistance },
+    { "lightDistance", &lightDistance },
+    { "redLightDistance", &redLightDistance },
+    { "blueLightDistance", &blueLightDistance },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "runcheckpoint2()", &runcheckpoint2 },
+    { "waitForLight()", &waitForLight },
+    { "gotocoloredlight()", &gotocoloredlight },
+    { "whatcolorisit()", &whatcolorisit },
+    { "comehome()", &comehome },
+};
+
 int main() {
-    ProteOS::registerVariable("redthreshold", &redthreshold);
-    ProteOS::registerVariable("bluethreshold", &bluethreshold);
-    ProteOS::registerVariable("rampDistance", &rampDistance);
-    ProteOS::registerVariable("kioskDistance", &kioskDistance);
-    ProteOS::registerVariable("lightDistance", &lightDistance);
-    ProteOS::registerVariable("redLightDistance", &redLightDistance);
-    ProteOS::registerVariable("blueLightDistance", &blueLightDistance);
-
-    ProteOS::registerFunction("runcheckpoint2()", &runcheckpoint2);
-    ProteOS::registerFunction("waitForLight()",&waitForLight);
-    ProteOS::registerFunction("gotocoloredlight()",&gotocoloredlight);
-    ProteOS::registerFunction("whatcolorisit()",&whatcolorisit);
-    ProteOS::registerFunction("comehome()",&comehome);
+    ProteOS::setAppName("Checkpoint2");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
     
     ProteOS::run();
 
@@ -53,45 +53,51 @@ void flipLeverUp();
 
 
 
+static constexpr ProteOSVariable variables[] = {
+    /* { "leversX", &leversX },
+    { "leversY", &leversY },
+    { "leversH", &leversH },
+    { "leverSpacing", &leverSpacing },
+    { "qrCodeX", &Motors::qrCodeX },
+    { "qrCodeY", &Motors::qrCodeY },
+    { "qrCodeA", &Motors::qrCodeA }, */
+    { "somewhereDist", &somewhereDist },
+    { "awayFromKioskDist", &awayFromKioskDist },
+    { "initialLeverDist", &initialLeverDist },
+    { "overshoot", &overshoot },
+    { "distToLever", &distToLever },
+
+    //for HARD CODING THE DISTANCE
+    /* { "distancetofirstlever", &firstlever },
+    { "testangle", &testangle }, */
+};
+
+static constexpr ProteOSFunction functions[] = {
+    //{ "calibrateServo()", &calibrateServo },
+    //{ "testServo()", &testServo },
+    //{ "initializeRPS()", &initializeRPS },
+    //{ "calibrateQRCode()", &calibrateQRCode },
+    //{ "displayPosition()", &displayPosition },
+    { "runCheckpoint()", &runCheckpoint },
+    { "lineupwithwall()", &lineupwithwall },
+    //{ "getCloserToLevers()", &getCloserToLevers }, //same thing as lineupwith wall just with RPS
+    { "goToLever()", &goToLever },
+    { "flipLever()", &flipLever },
+    //{ "flipLeverDown()", &flipLeverDown },
+    //{ "flipLeverUp()", &flipLeverUp },
+    //{ "testTurn()", &testTurn },
+    //{ "testDrive()", &testDrive },
+};
+
 int main() {
     mouthServo.SetMin(500);
     mouthServo.SetMax(2390);
     
     mouthServo.SetDegree(90); //set to neutral position
     
-    /* ProteOS::registerVariable("leversX", &leversX);
-    ProteOS::registerVariable("leversY", &leversY);
-    ProteOS::registerVariable("leversH", &leversH);
-    ProteOS::registerVariable("leverSpacing", &leverSpacing);
-    ProteOS::registerVariable("qrCodeX", &Motors::qrCodeX);
-    ProteOS::registerVariable("qrCodeY", &Motors::qrCodeY);
-    ProteOS::registerVariable("qrCodeA", &Motors::qrCodeA); */
-    ProteOS::registerVariable("somewhereDist", &somewhereDist);
-    ProteOS::registerVariable("awayFromKioskDist", &awayFromKioskDist);
-    ProteOS::registerVariable("initialLeverDist", &initialLeverDist);
-    ProteOS::registerVariable("overshoot", &overshoot);
-    ProteOS::registerVariable("distToLever", &distToLever);
-
-    //for HARD CODING THE DISTANCE
-    /* ProteOS::registerVariable("distancetofirstlever",&firstlever);
-    ProteOS::registerVariable("testangle",&testangle); */
-
-
-    
-    //ProteOS::registerFunction("calibrateServo()", &calibrateServo);
-    //ProteOS::registerFunction("testServo()", &testServo);
-    //ProteOS::registerFunction("initializeRPS()", &initializeRPS);
-    //ProteOS::registerFunction("calibrateQRCode()", &calibrateQRCode);
-    //ProteOS::registerFunction("displayPosition()", &displayPosition);
-    ProteOS::registerFunction("runCheckpoint()", &runCheckpoint);
-    ProteOS::registerFunction("lineupwithwall()",&lineupwithwall);
-    //ProteOS::registerFunction("getCloserToLevers()", &getCloserToLevers); //same thing as lineupwith wall just with RPS
-    ProteOS::registerFunction("goToLever()", &goToLever);
-    ProteOS::registerFunction("flipLever()", &flipLever);
-    //ProteOS::registerFunction("flipLeverDown()", &flipLeverDown);
-    //ProteOS::registerFunction("flipLeverUp()", &flipLeverUp);
-    //ProteOS::registerFunction("testTurn()", &testTurn);
-    //ProteOS::registerFunction("testDrive()", &testDrive);
+    ProteOS::setAppName("Checkpoint3");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
 
 
     ProteOS::run();
@@ -1 +1,2 @@
-Checkpoint4_LIBS := proteos debugger navigation
\ No newline at end of file
+Checkpoint4_LIBS := proteos debugger navigation
+Checkpoint4_LDFLAGS := -u _printf_float -u _scanf_float
\ No newline at end of file
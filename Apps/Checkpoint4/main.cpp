@@ -44,25 +44,34 @@ void check_heading(float);
 
 
 
+static constexpr ProteOSVariable variables[] = {
+    { "rampX", &rampX },
+    { "rampTopY", &rampTopY },
+    { "escapeToX", &escapeToX },
+    { "passportLeverY", &passportLeverY },
+    { "passportLeverX", &passportLeverX },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "waitForLight()", &waitForLight },
+    //{ "goToStation()", &akgoToStation },
+    { "gotostationR()", &reinagoToStation },
+    { "spinPassportLever()", &spinPassportLever },
+    { "runCheckpoint()", &runCheckpoint },
+    { "testLineUpAngle()", &testLineUpAngle },
+    { "testLineUpX()", &testLineUpX },
+};
+
 int main() {
     r2d2Servo.SetMin(500);
     r2d2Servo.SetMax(2315);
     r2d2Servo.SetDegree(90);
 
-    ProteOS::registerVariable("rampX", &rampX);
-    ProteOS::registerVariable("rampTopY", &rampTopY);
-    ProteOS::registerVariable("escapeToX", &escapeToX);
-    ProteOS::registerVariable("passportLeverY", &passportLeverY);
-    ProteOS::registerVariable("passportLeverX", &passportLeverX);
+    ProteOS::setAppName("Checkpoint4");
+    ProteOS::setVariables(variables);
 
     //registering main functions
-    ProteOS::registerFunction("waitForLight()", &waitForLight);
-    //ProteOS::registerFunction("goToStation()", &akgoToStation);
-    ProteOS::registerFunction("gotostationR()",&reinagoToStation);
-    ProteOS::registerFunction("spinPassportLever()", &spinPassportLever);
-    ProteOS::registerFunction("runCheckpoint()", &runCheckpoint);
-    ProteOS::registerFunction("testLineUpAngle()", &testLineUpAngle);
-    ProteOS::registerFunction("testLineUpX()", &testLineUpX);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 }
@@ -26,6 +26,14 @@ float rampTopY = 42;
 float luggageX = 20;
 float luggageY = 44;
 
+static constexpr ProteOSFunction functions[] = {
+    { "waitForLight()", &waitForLight },
+    { "gotoluggagedropoff()", &gotoluggagedropoff },
+    { "dropluggage()", &dropluggage },
+    { "runCheckpoint()", &runCheckpoint },
+    { "goToStopButton()", &goToStopButton },
+};
+
 int main() {
     mouthServo.SetMin(500);
     mouthServo.SetMax(2390);
@@ -33,11 +41,7 @@ int main() {
     mouthServo.SetDegree(60);
 
     //registering main functions
-    ProteOS::registerFunction("waitForLight()", &waitForLight);
-    ProteOS::registerFunction("gotoluggagedropoff()", &gotoluggagedropoff);
-    ProteOS::registerFunction("dropluggage()", &dropluggage);
-    ProteOS::registerFunction("runCheckpoint()", &runCheckpoint);
-    ProteOS::registerFunction("goToStopButton()", &goToStopButton);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 
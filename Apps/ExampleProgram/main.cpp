@@ -18,15 +18,23 @@ float var2 = 5.6f;
 
 float squareInput = 2;
 
+static constexpr ProteOSVariable variables[] = {
+    { "var1", &var1 },
+    { "var2", &var2 },
+    { "squareInput", &squareInput },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "stanley()", &stanley },
+    { "testSquare()", &testSquare },
+    { "computePi()", &computePi },
+    { "itsJoever()", &itsJoever },
+};
+
 int main(void) {
-    ProteOS::registerVariable("var1", &var1);
-    ProteOS::registerVariable("var2", &var2);
-    ProteOS::registerVariable("squareInput", &squareInput);
-
-    ProteOS::registerFunction("stanley()", &stanley);
-    ProteOS::registerFunction("testSquare()", &testSquare);
-    ProteOS::registerFunction("computePi()", &computePi);
-    ProteOS::registerFunction("itsJoever()", &itsJoever);
+    ProteOS::setAppName("ExampleProgram");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 }
@@ -1 +1,2 @@
 Checkpoint1_LIBS := proteos debugger navigation
+Exploration1_LDFLAGS := -u _printf_float -u _scanf_float
\ No newline at end of file
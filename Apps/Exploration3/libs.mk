@@ -1 +1,2 @@
-Exploration3_LIBS := proteos debugger navigation
\ No newline at end of file
+Exploration3_LIBS := proteos debugger navigation
+Exploration3_LDFLAGS := -u _printf_float -u _scanf_float
\ No newline at end of file
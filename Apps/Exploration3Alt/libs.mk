@@ -1 +1,2 @@
-Exploration3Alt_LIBS := proteos debugger navigation
\ No newline at end of file
+Exploration3Alt_LIBS := proteos debugger navigation
+Exploration3Alt_LDFLAGS := -u _printf_float -u _scanf_float
\ No newline at end of file
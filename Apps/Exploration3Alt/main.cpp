@@ -407,14 +407,18 @@ void displayRPSInfo() {
     }
 }
 
+static constexpr ProteOSFunction functions[] = {
+    { "initializeRPS()", &initializeRPS },
+    { "setPOIs()", &setPOIs },
+    { "goToPOIs()", &goToPOIs },
+    { "readPOIs()", &readPOIs },
+    { "readResults()", &readResults },
+    { "displayRPSInfo()", &displayRPSInfo },
+};
+
 int main()
 {
-    ProteOS::registerFunction("initializeRPS()", &initializeRPS);
-    ProteOS::registerFunction("setPOIs()", &setPOIs);
-    ProteOS::registerFunction("goToPOIs()", &goToPOIs);
-    ProteOS::registerFunction("readPOIs()", &readPOIs);
-    ProteOS::registerFunction("readResults()", &readResults);
-    ProteOS::registerFunction("displayRPSInfo()", &displayRPSInfo);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 }
@@ -1 +1,2 @@
-LightSensorTest_LIBS := proteos debugger navigation
+LightSensorTest_LIBS := proteos debugger navigation sampler startlight widgets
+LightSensorTest_LDFLAGS := -u _printf_float -u _scanf_float
\ No newline at end of file
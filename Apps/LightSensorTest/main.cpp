@@ -1,5 +1,8 @@
 #include <proteos.hpp>
 #include "navigation.hpp"
+#include "sampler.hpp"
+#include "startlight.hpp"
+#include "widgets.hpp"
 
 #include <FEHLCD.h>
 #include <FEHIO.h>
@@ -12,6 +15,10 @@
 
 //DECLARING INPUTS
 AnalogInputPin cds(FEHIO::P0_0); //configure Cds cell as an analog input
+static int cdsChannel;
+
+// Below the sensor value, over debugger rows 4 to 11
+static StripChart cdsChart(0, 68, 320, 136);
 
 
 //DECLARING FUNCTIONS
@@ -19,10 +26,28 @@ void StartAtLight();
 void TraveltoKiosk();
 void DisplaySensorReading();
 
+static constexpr ProteOSVariable variables[] = {
+    { "darkLevel", &StartLight::darkLevel },
+    { "litLevel", &StartLight::litLevel },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "StartAtLight()", &StartAtLight },
+    { "TraveltoKiosk()", &TraveltoKiosk },
+    { "DisplaySensorReading()", &DisplaySensorReading },
+    { "calibrateDark()", &StartLight::calibrateDark },
+    { "calibrateLit()", &StartLight::calibrateLit },
+};
+
 int main() {
-    ProteOS::registerFunction("StartAtLight()", &StartAtLight);
-    ProteOS::registerFunction("TraveltoKiosk()", &TraveltoKiosk);
-    ProteOS::registerFunction("DisplaySensorReading()", &DisplaySensorReading);
+    cdsChannel = Sampler::registerPin(&cds);
+    StartLight::setup(cdsChannel);
+
+    ProteOS::setAppName("LightSensorTest");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
+
+    ProteOS::registerReport("Start light", &StartLight::drawReport);
 
     ProteOS::run(); // "runs the os" opens the interface to run functions
 }
@@ -34,25 +59,45 @@ void StartAtLight() {
     Debugger::printWrap(1, "Received input, waiting for light");
 
     //wait for light
-    while (cds.Value()>2.50); //if no light do nothing
+    StartLight::wait(30);
     Debugger::printWrap(3, "NOW AT LAST I SEEEE THE LIGHT");
     TraveltoKiosk();
 }
 
 //function to allow robot to travel to kiosk (right now testing if react to light turning on)
 void TraveltoKiosk(){
-    Motors::lMotor.SetPercent(MOTOR_POWER_MED);
-    Motors::rMotor.SetPercent(MOTOR_POWER_MED);
-    Sleep(2.0);
-    Motors::lMotor.SetPercent(MOTOR_STOP);
-    Motors::rMotor.SetPercent(MOTOR_STOP);
-    
+    // (goes through Motors so StartLight can time the reaction)
+    Motors::pulse_forward((int) MOTOR_POWER_MED, 2.0f);
+}
+
+static float readCds() {
+    return Sampler::value(cdsChannel);
+}
+
+static float readDarkLevel() {
+    return StartLight::darkLevel;
+}
+
+static float readLitLevel() {
+    return StartLight::litLevel;
 }
 
 void DisplaySensorReading() {
+    // The CdS cell's voltage, against the calibrated levels it is compared to
+    static bool chartSetUp = false;
+    if (!chartSetUp) {
+        cdsChart.addSignal(&readCds, 0, 3.3f, Debugger::defaultFontColor);
+        cdsChart.addSignal(&readDarkLevel, 0, 3.3f, 0x606060);
+        cdsChart.addSignal(&readLitLevel, 0, 3.3f, 0xFFFF00);
+        chartSetUp = true;
+    }
+    cdsChart.reset(Debugger::defaultFontColor);
+    Debugger::forgetScreen();
+
     while (true) {
-        Debugger::printLine(2, "Sensor Value: %f", cds.Value());
-        Debugger::sleep(0.5);
+        Debugger::printLine(2, "Sensor Value: %f", readCds());
+        cdsChart.sample();
+        Debugger::sleep(0.02f);
     }
 }
 /*
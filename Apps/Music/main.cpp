@@ -51,10 +51,14 @@ void tune2() {
     note(Buzzer.Fs4, 3/4.);
 }
 
+static constexpr ProteOSFunction functions[] = {
+    { "tune1()", &tune1 },
+    { "tune2()", &tune2 },
+};
+
 int main() {
     LCD.Clear();
-    ProteOS::registerFunction("tune1()", &tune1);
-    ProteOS::registerFunction("tune2()", &tune2);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 }
\ No newline at end of file
@@ -1 +1 @@
-Showcase_LIBS := proteos debugger navigation
+Showcase_LIBS := proteos crashdump debugger navigation pcsampler sampler loopmonitor meminfo profiler startlight telemetry timeline tracelog uartstream
@@ -1,5 +1,17 @@
 #include "proteos.hpp"
+#include "batterymonitor.hpp"
+#include "crashdump.hpp"
 #include "navigation.hpp"
+#include "pcsampler.hpp"
+#include "sampler.hpp"
+#include "loopmonitor.hpp"
+#include "meminfo.hpp"
+#include "profiler.hpp"
+#include "startlight.hpp"
+#include "telemetry.hpp"
+#include "timeline.hpp"
+#include "tracelog.hpp"
+#include "uartstream.hpp"
 
 #include "FEHRPS.h"
 #include "FEHServo.h"
@@ -8,6 +20,7 @@
 #include <cmath>
 
 AnalogInputPin lightSensor(FEHIO::P0_7);
+static int lightChannel;
 
 FEHServo r2d2Servo(FEHServo::Servo1);
 FEHServo mouthServo(FEHServo::Servo0);
@@ -39,6 +52,30 @@ int getLightColor();
 void OLD_runCourse();
 
 
+static constexpr ProteOSVariable variables[] = {
+    { "motorPower", &Motors::maxPower },
+    { "leverCorrection", &leverCorrection },
+    /* { "leverAngle0", &leverAngles[0] },
+    { "leverAngle1", &leverAngles[1] },
+    { "leverAngle2", &leverAngles[2] }, */
+    /* { "leverDist0", &leverDists[0] },
+    { "leverDist1", &leverDists[1] },
+    { "leverDist2", &leverDists[2] }, */
+    { "doPassportLeverCorrection", &doPassportLeverCorrection },
+    { "otherLeverCorrection", &otherLeverCorrection },
+    { "darkLevel", &StartLight::darkLevel },
+    { "litLevel", &StartLight::litLevel },
+    { "doWillThing", &doWillThing },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "runCourse()", &runCourse },
+    { "OLD_runCourse()", &OLD_runCourse },
+    { "calibrateDark()", &StartLight::calibrateDark },
+    { "calibrateLit()", &StartLight::calibrateLit },
+    { "uartStream()", &UartStream::begin },
+};
+
 int main() {
     mouthServo.SetMin(500);
     mouthServo.SetMax(2390);
@@ -46,37 +83,43 @@ int main() {
     r2d2Servo.SetMax(2315);
     mouthServo.SetDegree(60);
     r2d2Servo.SetDegree(90);
+
+    lightChannel = Sampler::registerPin(&lightSensor);
+    StartLight::setup(lightChannel);
+    CrashDump::install();
+    Telemetry::enable();
+    Telemetry::onFlush = &MemInfo::writeTelemetry;
+    TraceLog::enable();
+    PcSampler::enable();
+    BatteryMonitor::enable();
     
-    ProteOS::registerVariable("motorPower", &Motors::maxPower);
-    ProteOS::registerVariable("leverCorrection", &leverCorrection);
-    /* ProteOS::registerVariable("leverAngle0", &leverAngles[0]);
-    ProteOS::registerVariable("leverAngle1", &leverAngles[1]);
-    ProteOS::registerVariable("leverAngle2", &leverAngles[2]); */
-    /* ProteOS::registerVariable("leverDist0", &leverDists[0]);
-    ProteOS::registerVariable("leverDist1", &leverDists[1]);
-    ProteOS::registerVariable("leverDist2", &leverDists[2]); */
-    ProteOS::registerVariable("doPassportLeverCorrection", &doPassportLeverCorrection);
-    ProteOS::registerVariable("otherLeverCorrection", &otherLeverCorrection);
-    ProteOS::registerVariable("doWillThing", &doWillThing);
-
-    ProteOS::registerFunction("runCourse()", &runCourse);
-    ProteOS::registerFunction("OLD_runCourse()", &OLD_runCourse);
+    ProteOS::setAppName("Showcase");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
+
+    ProteOS::registerReport("Phases", &Timeline::drawReport);
+    ProteOS::registerReport("Loops", &LoopMonitor::drawReport);
+    ProteOS::registerReport("Profile", &ProfileZone::drawReport);
+    ProteOS::registerReport("Memory", &MemInfo::drawReport);
+    ProteOS::registerReport("Battery", &BatteryMonitor::drawReport);
+    ProteOS::registerReport("Start light", &StartLight::drawReport);
+    ProteOS::registerReport("Trace", &TraceLog::drawReport);
 
     ProteOS::run();
 }
 
 void runCourse() {
-    waitForLight();
-    goToLuggageDropoff();
-    dropLuggage();
-    goToLight();
-    pressKioskButton();
-    goToPassportStation();
-    spinPassportLever();
-    goBackDownTheRamp();
-    goToLevers();
-    flipLever();
-    hitStopButton();
+    Timeline::runPhase("waitForLight", &waitForLight);
+    Timeline::runPhase("goToLuggageDropoff", &goToLuggageDropoff);
+    Timeline::runPhase("dropLuggage", &dropLuggage);
+    Timeline::runPhase("goToLight", &goToLight);
+    Timeline::runPhase("pressKioskButton", &pressKioskButton);
+    Timeline::runPhase("goToPassportStation", &goToPassportStation);
+    Timeline::runPhase("spinPassportLever", &spinPassportLever);
+    Timeline::runPhase("goBackDownTheRamp", &goBackDownTheRamp);
+    Timeline::runPhase("goToLevers", &goToLevers);
+    Timeline::runPhase("flipLever", &flipLever);
+    Timeline::runPhase("hitStopButton", &hitStopButton);
 }
 
 void precise() {
@@ -92,13 +135,8 @@ void fast() {
 void waitForLight() {
     Debugger::printLine(0, "Waiting for light...");
 
-    float startTime = TimeNow();
-
-    // wait for light
-    while (lightSensor.Value()>1) { // if no light do nothing
-        Debugger::abortCheck();
-        if (TimeNow() > startTime + 30) break;
-    }
+    // wait for light, giving up after 30 seconds
+    StartLight::wait(30);
 
 
     // Change font color to yellow
@@ -188,10 +226,13 @@ int getLightColor() {
     Motors::lMotor.SetPercent(20);
     Motors::rMotor.SetPercent(20);
     while (TimeNow() < startTime + 1) {
-        if (lightSensor.Value() < 0.4) {
+        // min() covers every reading in the sampler's window, so a short flash of red
+        //   between two checks is still caught
+        if (Sampler::min(lightChannel) < 0.4) {
             color = 1;
             break;
         }
+        Debugger::abortCheck();
     }
     Motors::stop();
 
@@ -28,6 +28,15 @@ void hitStopButton();
 int getLightColor();
 
 
+static constexpr ProteOSVariable variables[] = {
+    { "motorPower", &Motors::maxPower },
+    { "leverCorrection", &leverCorrection },
+};
+
+static constexpr ProteOSFunction functions[] = {
+    { "runCourse()", &runCourse },
+};
+
 int main() {
     mouthServo.SetMin(500);
     mouthServo.SetMax(2390);
@@ -36,10 +45,9 @@ int main() {
     mouthServo.SetDegree(60);
     r2d2Servo.SetDegree(90);
     
-    ProteOS::registerVariable("motorPower", &Motors::maxPower);
-    ProteOS::registerVariable("leverCorrection", &leverCorrection);
-
-    ProteOS::registerFunction("runCourse()", &runCourse);
+    ProteOS::setAppName("ShowcaseOld");
+    ProteOS::setVariables(variables);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();
 }
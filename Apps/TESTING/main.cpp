@@ -8,10 +8,14 @@ void testingback();
 void testingforward();
 void abortTest();
 
+static constexpr ProteOSFunction functions[] = {
+    { "testingback", &testingback },
+    { "testingforward", &testingforward },
+    { "abortTest", &abortTest },
+};
+
 int main() {
-    ProteOS::registerFunction("testingback", &testingback);
-    ProteOS::registerFunction("testingforward", &testingforward);
-    ProteOS::registerFunction("abortTest", &abortTest);
+    ProteOS::setFunctions(functions);
 
     ProteOS::run();   
 }
@@ -27,5 +31,5 @@ void testingforward(){
 void abortTest() {
     Motors::start(true);
     Debugger::printNextLine("no cap?");
-    throw new AbortException();
+    Debugger::abort();
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include <FEHBuzzer.h>
 #include <FEHLCD.h>
 
+#include "assert.hpp"
+
+void (*_AssertHook)(const char *, int, const char *, const char *) = nullptr;
+
 [[noreturn]] void _Assert(
     const char *file,
     const int line,
@@ -32,6 +36,10 @@
     LCD.SetFontColor(LCD.White);
     LCD.WriteRC("is false.", 13, 9);
 
+    if (_AssertHook != nullptr) {
+        _AssertHook(file, line, fn, cond);
+    }
+
     FEHBuzzer().Beep();
     // Spin.
     while (true);
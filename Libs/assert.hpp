@@ -6,6 +6,12 @@
 
 [[noreturn]] extern void _Assert(const char *, int, const char *, const char *);
 
+//! \brief If set, called by `_Assert` with the same arguments before it halts.
+//!
+//! This lets a library such as *crashdump* record the failure somewhere that outlives a
+//! power cycle. `_Assert` halts as usual once the hook returns.
+extern void (*_AssertHook)(const char *, int, const char *, const char *);
+
 #ifdef __GNUC__
 #define likely(x)   __builtin_expect((x), 1)
 #define unlikely(x) __builtin_expect((x), 0)
@@ -0,0 +1,108 @@
+#include "batterymonitor.hpp"
+
+#include "debugger.hpp"
+#include "format.hpp"
+#include "ticker.hpp"
+
+#include "FEHBattery.h"
+#include "FEHLCD.h"
+#include "FEHUtility.h"
+
+
+// Static variable definitions
+
+bool BatteryMonitor::enabled = false;
+bool BatteryMonitor::started = false;
+uint32_t BatteryMonitor::lastReadMs = 0;
+BatteryStats BatteryMonitor::current;
+LatestValue<BatteryStats> BatteryMonitor::latest;
+
+// Set by a debugger start handler, and cleared by the next reading when it restarts the minimum
+static volatile bool minimumResetDue = false;
+
+
+// Function definitions
+
+void BatteryMonitor::enable() {
+    if (enabled) return;
+    enabled = true;
+
+    if (!started) start();
+    Ticker::addTask(&sample, BATTERY_PERIOD_MS);
+}
+
+float BatteryMonitor::voltage() {
+    BatteryStats s;
+    stats(&s);
+    return s.voltage;
+}
+
+float BatteryMonitor::minimum() {
+    BatteryStats s;
+    stats(&s);
+    return s.minimum;
+}
+
+bool BatteryMonitor::isLow() {
+    return voltage() < BATTERY_LOW_VOLTAGE;
+}
+
+void BatteryMonitor::stats(BatteryStats* out) {
+    if (!started) {
+        start();
+    } else if (!enabled && TimeNowMSec() - lastReadMs >= BATTERY_PERIOD_MS) {
+        lastReadMs = TimeNowMSec();
+        sample();
+    }
+    latest.read(out);
+}
+
+void BatteryMonitor::drawReport() {
+    BatteryStats s;
+    stats(&s);
+    char buf[BUFFER_SIZE + 1];
+
+    Format::print(buf, BUFFER_SIZE, "Filtered: %.2f V", s.voltage);
+    LCD.WriteAt(buf, 16, 40);
+    Format::print(buf, BUFFER_SIZE, "Latest:   %.2f V", s.latest);
+    LCD.WriteAt(buf, 16, 64);
+    Format::print(buf, BUFFER_SIZE, "Min:      %.2f V", s.minimum);
+    LCD.WriteAt(buf, 16, 88);
+    Format::print(buf, BUFFER_SIZE, "Sag:      %.2f V", s.voltage - s.minimum);
+    LCD.WriteAt(buf, 16, 112);
+    if (s.voltage < BATTERY_LOW_VOLTAGE) {
+        LCD.WriteAt("Battery low", 16, 148);
+    }
+}
+
+void BatteryMonitor::start() {
+    started = true;
+
+    // Start the filter at a real reading rather than at 0
+    float reading = Battery.Voltage();
+    lastReadMs = TimeNowMSec();
+    current.voltage = reading;
+    current.latest = reading;
+    current.minimum = reading;
+    current.sampleCount = 1;
+    latest.write(current);
+
+    Debugger::addStartHandler(&resetMinimum);
+}
+
+void BatteryMonitor::sample() {
+    float reading = Battery.Voltage();
+
+    current.latest = reading;
+    current.voltage += BATTERY_FILTER_WEIGHT * (reading - current.voltage);
+    if (minimumResetDue || reading < current.minimum) {
+        current.minimum = reading;
+        minimumResetDue = false;
+    }
+    current.sampleCount++;
+    latest.write(current);
+}
+
+void BatteryMonitor::resetMinimum() {
+    minimumResetDue = true;
+}
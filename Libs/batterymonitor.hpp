@@ -0,0 +1,81 @@
+#ifndef BATTERYMONITOR_HPP
+#define BATTERYMONITOR_HPP
+
+#include "stdint.h"
+
+#include "spsc.hpp"
+
+
+// Time between battery readings, in milliseconds
+#define BATTERY_PERIOD_MS 100
+
+// Weight of each new reading in the filtered voltage. At BATTERY_PERIOD_MS, 0.1 smooths over
+//   about a second, so short sags from the motors starting barely move it.
+#define BATTERY_FILTER_WEIGHT 0.1f
+
+// Filtered voltage below which the battery is reported as low
+#define BATTERY_LOW_VOLTAGE 11.0f
+
+
+// A snapshot of the battery, as of the latest reading.
+struct BatteryStats {
+    // Filtered voltage
+    float voltage;
+    // The most recent unfiltered reading
+    float latest;
+    // The lowest unfiltered reading since the last run started (or since boot), which is how
+    //   far the voltage sags under load
+    float minimum;
+    uint32_t sampleCount;
+};
+
+
+// Tracks the battery voltage, so control loops, logging and the menu can all get it without
+//   each doing an ADC conversion.
+//
+// By default, the accessors read Battery.Voltage() from the main program, at most once every
+//   BATTERY_PERIOD_MS, and otherwise return the cached reading. After enable(), readings are
+//   taken from the ticker interrupt instead, which like the Sampler can collide with any
+//   AnalogInputPin::Value() call from the main program. So only apps that read all of their
+//   analog pins through the Sampler should enable it.
+class BatteryMonitor {
+public:
+
+    // Starts sampling every BATTERY_PERIOD_MS from the ticker interrupt, if it hasn't started
+    //   already, so the readings stay current while the main program is busy. Battery.Voltage()
+    //   and AnalogInputPin::Value() shouldn't be called directly after this.
+    static void enable();
+
+    // The filtered voltage. Cheap: touches the ADC at most once every BATTERY_PERIOD_MS, and
+    //   never once enable() has been called.
+    static float voltage();
+
+    // The lowest reading since the last debugger run started.
+    static float minimum();
+
+    // Whether the filtered voltage is below BATTERY_LOW_VOLTAGE.
+    static bool isLow();
+
+    // Copies the whole latest snapshot.
+    static void stats(BatteryStats* out);
+
+    // Draws the battery readings, for use with ProteOS::registerReport().
+    static void drawReport();
+
+
+private:
+    static bool enabled;
+    // Whether the first reading has been taken
+    static bool started;
+    // TimeNowMSec() of the last reading taken from the main program
+    static uint32_t lastReadMs;
+    // Only touched by the interrupt once enabled
+    static BatteryStats current;
+    static LatestValue<BatteryStats> latest;
+
+    static void start();
+    static void sample();
+    static void resetMinimum();
+};
+
+#endif
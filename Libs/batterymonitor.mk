@@ -0,0 +1 @@
+batterymonitor_LIBS := debugger format ticker
\ No newline at end of file
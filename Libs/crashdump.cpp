@@ -0,0 +1,209 @@
+#include "crashdump.hpp"
+
+#include "assert.hpp"
+#include "debugger.hpp"
+#include "format.hpp"
+#include "navigation.hpp"
+#include "telemetry.hpp"
+#include "timeline.hpp"
+
+#include "stddef.h"
+
+#include "FEHLCD.h"
+#include "FEHSD.h"
+#include "FEHUtility.h"
+
+
+// Cortex-M4 system registers (ARMv7-M Architecture Reference Manual, B3.2.2 and B3.2.15-18)
+static volatile uint32_t* const vectorTableOffset = (volatile uint32_t*) 0xE000ED08;
+static volatile uint32_t* const configurableFaultStatus = (volatile uint32_t*) 0xE000ED28;
+static volatile uint32_t* const hardFaultStatus = (volatile uint32_t*) 0xE000ED2C;
+static volatile uint32_t* const memManageFaultAddress = (volatile uint32_t*) 0xE000ED34;
+static volatile uint32_t* const busFaultAddress = (volatile uint32_t*) 0xE000ED38;
+
+// Bit 9 of the stacked xPSR says the processor added a padding word to align the stack
+#define XPSR_STACK_ALIGNED (1u << 9)
+// xPSR with only the Thumb bit set, for returning into finishFault()
+#define XPSR_THUMB (1u << 24)
+
+#define CRASH_REASON_SIZE 96
+
+// Longest line written with Format::print() before it goes to the file
+#define CRASH_LINE_SIZE 128
+
+
+// Static variable definitions
+
+CrashRegisters CrashDump::faultRegisters;
+volatile bool CrashDump::faulted = false;
+
+
+// Function definitions
+
+// frame is the exception frame the hardware pushed when the fault happened.
+extern "C" void crashDumpFault(uint32_t* frame, uint32_t excReturn) {
+    CrashDump::fault(frame, excReturn);
+}
+
+// Passes the stack the faulting code was using, and the EXC_RETURN value, on to
+//   crashDumpFault(). Naked for the same reason as SysTick_Handler in ticker.cpp. Because
+//   this branches rather than calls, crashDumpFault() returns straight out of the fault.
+extern "C" __attribute__((naked)) void HardFault_Handler() {
+    __asm volatile(
+        "tst lr, #4\n"
+        "ite eq\n"
+        "mrseq r0, msp\n"
+        "mrsne r0, psp\n"
+        "mov r1, lr\n"
+        "b crashDumpFault\n"
+    );
+}
+
+// Stops the robot and shows the reason until it is power cycled.
+[[noreturn]] static void halt(const char* reason, bool saved) {
+    Motors::stop();
+
+    LCD.Clear(RED);
+    LCD.SetFontColor(LCD.White);
+    LCD.WriteLine(reason);
+    LCD.WriteLine("");
+    LCD.WriteLine(saved ? "Saved to " CRASH_FILE : "Could not save " CRASH_FILE);
+
+    while (true);
+}
+
+// abort() is wrapped at link time (see crashdump.mk), which also catches std::terminate()
+extern "C" [[noreturn]] void __wrap_abort() {
+    // abort() while saving a dump; the first one is the one worth keeping
+    static volatile bool aborting = false;
+    if (aborting) while (true);
+    aborting = true;
+    halt("abort() called", CrashDump::save("abort() called", NULL));
+}
+
+void CrashDump::install() {
+    _AssertHook = &saveAssert;
+    Debugger::addFailureHandler(&saveFailure);
+}
+
+// Writes the stack from sp up to where it started, which is read from the vector table.
+static void writeStack(FEHFile* file, uint32_t sp) {
+    uint32_t stackTop = *(volatile uint32_t*) (uintptr_t) *vectorTableOffset;
+    if ((sp & 3) != 0 || sp >= stackTop) {
+        SD.FPrintf(file, "stack %08lx unreadable\n", (unsigned long) sp);
+        return;
+    }
+
+    int words = (int) ((stackTop - sp) / 4);
+    if (words > CRASH_STACK_WORDS) words = CRASH_STACK_WORDS;
+    SD.FPrintf(file, "stack %08lx, %i words\n", (unsigned long) sp, words);
+
+    const uint32_t* stack = (const uint32_t*) (uintptr_t) sp;
+    for (int i = 0; i < words; i += 4) {
+        SD.FPrintf(file, "%08lx:", (unsigned long) (sp + 4*i));
+        for (int j = i; j < i + 4 && j < words; j++) {
+            SD.FPrintf(file, " %08lx", (unsigned long) stack[j]);
+        }
+        SD.FPrintf(file, "\n");
+    }
+}
+
+static void writeTelemetry(FEHFile* file) {
+    int n = Telemetry::count();
+    int first = n > CRASH_TELEMETRY_RECORDS ? n - CRASH_TELEMETRY_RECORDS : 0;
+    SD.FPrintf(file, "telemetry %i (ms left right lpower rpower x y heading rpsx rpsy rpsheading)\n",
+               n - first);
+
+    // Floats are formatted here rather than by FPrintf(), so the firmware's printf doesn't need
+    //   float support linked in
+    char line[CRASH_LINE_SIZE];
+    TelemetryRecord r;
+    for (int i = first; i < n; i++) {
+        Telemetry::get(i, &r);
+        Format::print(line, CRASH_LINE_SIZE, "%lu %li %li %i %i %.2f %.2f %.1f %.2f %.2f %.1f",
+                      (unsigned long) r.timeMs, (long) r.leftCounts, (long) r.rightCounts, r.leftPower,
+                      r.rightPower, r.x, r.y, r.heading, r.rpsX, r.rpsY, r.rpsHeading);
+        SD.FPrintf(file, "%s\n", line);
+    }
+}
+
+bool CrashDump::save(const char* reason, const CrashRegisters* regs) {
+    FEHFile* file = SD.FOpen(CRASH_FILE, "a");
+    if (file == NULL) return false;
+
+    const char* phase = Timeline::currentPhase();
+    SD.FPrintf(file, "CRASH %s\n", reason);
+    char line[CRASH_LINE_SIZE];
+    Format::print(line, CRASH_LINE_SIZE, "time %.3f phase %s", TimeNow(), phase != NULL ? phase : "-");
+    SD.FPrintf(file, "%s\n", line);
+
+    uint32_t sp;
+    if (regs != NULL) {
+        SD.FPrintf(file, "r0 %08lx r1 %08lx r2 %08lx r3 %08lx\n", (unsigned long) regs->r0,
+                   (unsigned long) regs->r1, (unsigned long) regs->r2, (unsigned long) regs->r3);
+        SD.FPrintf(file, "r12 %08lx lr %08lx pc %08lx xpsr %08lx\n", (unsigned long) regs->r12,
+                   (unsigned long) regs->lr, (unsigned long) regs->pc, (unsigned long) regs->xpsr);
+        // MMFAR and BFAR only hold an address if CFSR says so (bits 7 and 15)
+        SD.FPrintf(file, "cfsr %08lx hfsr %08lx mmfar %08lx bfar %08lx exc_return %08lx\n",
+                   (unsigned long) regs->cfsr, (unsigned long) regs->hfsr, (unsigned long) regs->mmfar,
+                   (unsigned long) regs->bfar, (unsigned long) regs->excReturn);
+        sp = regs->sp;
+    } else {
+        sp = (uint32_t) (uintptr_t) __builtin_frame_address(0);
+    }
+    writeStack(file, sp);
+    writeTelemetry(file);
+
+    SD.FPrintf(file, "\n");
+    SD.FClose(file);
+    return true;
+}
+
+void CrashDump::fault(uint32_t* frame, uint32_t excReturn) {
+    // A fault while handling a fault; there is nothing more that can be done safely
+    if (faulted) while (true);
+    faulted = true;
+
+    CrashRegisters& r = faultRegisters;
+    r.r0 = frame[0];
+    r.r1 = frame[1];
+    r.r2 = frame[2];
+    r.r3 = frame[3];
+    r.r12 = frame[4];
+    r.lr = frame[5];
+    r.pc = frame[6];
+    r.xpsr = frame[7];
+    r.sp = (uint32_t) (uintptr_t) (frame + 8) + ((r.xpsr & XPSR_STACK_ALIGNED) ? 4 : 0);
+    r.excReturn = excReturn;
+    r.cfsr = *configurableFaultStatus;
+    r.hfsr = *hardFaultStatus;
+    r.mmfar = *memManageFaultAddress;
+    r.bfar = *busFaultAddress;
+
+    // The SD card can't be written from inside the fault handler, since the interrupts it
+    //   relies on can't preempt it. Instead, return from the fault into finishFault(), as if
+    //   the faulting code had jumped there. Its stack starts where the faulting code's
+    //   ended, so the words above that, which get dumped, are left alone.
+    frame[6] = (uint32_t) (uintptr_t) &finishFault & ~1u;
+    frame[7] = XPSR_THUMB;
+}
+
+void CrashDump::finishFault() {
+    char reason[CRASH_REASON_SIZE];
+    Format::print(reason, CRASH_REASON_SIZE, "Hard fault at pc %08lx", (unsigned long) faultRegisters.pc);
+    halt(reason, save(reason, &faultRegisters));
+}
+
+void CrashDump::saveFailure(const char* reason) {
+    if (!save(reason, NULL)) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printNextLine("Crash dump not saved");
+        Debugger::setFontColor();
+    }
+}
+
+void CrashDump::saveAssert(const char* file, int line, const char* function, const char* condition) {
+    char reason[CRASH_REASON_SIZE];
+    Format::print(reason, CRASH_REASON_SIZE, "assert(%s) failed at %s:%i in %s()", condition, file, line, function);
+    save(reason, NULL);
+}
@@ -0,0 +1,63 @@
+#ifndef CRASHDUMP_HPP
+#define CRASHDUMP_HPP
+
+#include "stdint.h"
+
+
+// File on the SD card that dumps are appended to
+#define CRASH_FILE "CRASH.TXT"
+
+// How many words above the stack pointer are saved
+#define CRASH_STACK_WORDS 32
+
+// How many of the most recent telemetry records are saved
+#define CRASH_TELEMETRY_RECORDS 16
+
+
+// The registers the processor pushed when a fault happened, and the fault status registers
+//   that say what went wrong (ARMv7-M Architecture Reference Manual, B3.2.15 to B3.2.18).
+struct CrashRegisters {
+    uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;
+    // Stack pointer before the fault, and the lr the fault handler was entered with
+    uint32_t sp, excReturn;
+    uint32_t cfsr, hfsr, mmfar, bfar;
+};
+
+
+// Saves what the robot was doing when something went wrong, so it can be looked at after the
+//   robot has been power cycled. A dump is appended to CRASH_FILE when:
+//   - a function run in the debugger fails an assertTrue() or is aborted,
+//   - an assert() from assert.hpp fails,
+//   - abort() is called, including by std::terminate() for an uncaught exception,
+//   - the processor takes a hard fault (bad pointer, bad instruction, divide by zero, ...).
+//
+// Each dump has the reason, the current Timeline phase, the registers (for faults), the top
+//   of the stack, and the last CRASH_TELEMETRY_RECORDS telemetry records.
+//
+// Linking this library is enough for faults and abort(); call install() to also catch
+//   failed asserts and debugger runs.
+class CrashDump {
+public:
+
+    // Hooks the dump into assert() and the debugger.
+    static void install();
+
+    // Appends a dump to CRASH_FILE. regs can be NULL if there are no fault registers; the
+    //   stack is then saved from the caller's stack pointer. Returns false if the file could
+    //   not be written.
+    static bool save(const char* reason, const CrashRegisters* regs);
+
+    // Called by the hard fault handler; do not call directly.
+    static void fault(uint32_t* frame, uint32_t excReturn);
+
+
+private:
+    static CrashRegisters faultRegisters;
+    static volatile bool faulted;
+
+    static void saveFailure(const char* reason);
+    static void saveAssert(const char* file, int line, const char* function, const char* condition);
+    static void finishFault();
+};
+
+#endif
@@ -0,0 +1,2 @@
+crashdump_LIBS := assert debugger format navigation telemetry timeline
+crashdump_LDFLAGS := -Wl,--wrap=abort
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef CYCLES_HPP
+#define CYCLES_HPP
+
+#include "stdint.h"
+
+
+// Core clock of the MK60 as configured by the firmware's startup code. SysTick and the DWT
+//   cycle counter both count core clock cycles.
+#ifndef CORE_CLOCK_HZ
+#define CORE_CLOCK_HZ 88000000
+#endif
+
+#define CYCLES_PER_MICROSECOND (CORE_CLOCK_HZ / 1000000)
+
+
+// The Cortex-M4 DWT cycle counter: a free-running 32-bit count of core clock cycles that costs
+//   a single load to read. It wraps about every 48 seconds, so only use it for differences
+//   shorter than that (unsigned subtraction handles a single wrap).
+class CycleCounter {
+public:
+
+    // Enables the counter. Safe to call more than once.
+    static void start() {
+        // DEMCR.TRCENA powers up the DWT, then DWT_CTRL.CYCCNTENA starts the count
+        *(volatile uint32_t*) debugExceptionMonitorControl |= 0x01000000u;
+        *(volatile uint32_t*) dwtControl |= 0x1u;
+    }
+
+    // The current cycle count.
+    static uint32_t now() {
+        return *(volatile uint32_t*) dwtCycleCount;
+    }
+
+    // Converts a number of cycles to microseconds.
+    static uint32_t toMicros(uint32_t cycles) {
+        return cycles / CYCLES_PER_MICROSECOND;
+    }
+
+    // Converts a number of microseconds to cycles. Only valid below about 48 seconds.
+    static uint32_t fromMicros(uint32_t micros) {
+        return micros * CYCLES_PER_MICROSECOND;
+    }
+
+
+private:
+    // ARMv7-M Architecture Reference Manual, C1.6.5 and C1.8.7
+    static const uint32_t debugExceptionMonitorControl = 0xE000EDFC;
+    static const uint32_t dwtControl = 0xE0001000;
+    static const uint32_t dwtCycleCount = 0xE0001004;
+};
+
+#endif
@@ -1,14 +1,15 @@
 #include "debugger.hpp"
 
 #include "string.h"
-#include "stdio.h"
 #include "stdlib.h"
-#include "stdarg.h"
-#include "exception"
 
+#include "assert.hpp"
 #include "navigation.hpp"
+#include "profiler.hpp"
+#include "ticker.hpp"
 
 #include "FEHLCD.h"
+#include "FEHSD.h"
 
 
 // Static variable definitions
@@ -18,26 +19,56 @@ const int Debugger::defaultFontColor = 0x00E0F0;
 const int Debugger::errorColor = 0xFF0000;
 
 bool Debugger::inDebugger = false;
+
+jmp_buf Debugger::runExit;
+bool Debugger::running = false;
+Debugger::RunOutcome Debugger::outcome = Debugger::Completed;
+const char* Debugger::failedFunction = "";
+int Debugger::failedLine = 0;
+const char* Debugger::failedMessage = "";
 int Debugger::debuggerFontColor = Debugger::defaultFontColor;
 
 char Debugger::debuggerText[HEIGHT_CHARS][WIDTH_CHARS + 1];
 
+char Debugger::scrollback[SCROLLBACK_LINES][WIDTH_CHARS + 1];
+int Debugger::scrollbackColors[SCROLLBACK_LINES];
+int Debugger::scrollbackTotal = 0;
+int Debugger::rowLines[HEIGHT_CHARS];
+
+char Debugger::shownText[HEIGHT_CHARS][WIDTH_CHARS];
+int Debugger::shownColors[HEIGHT_CHARS][WIDTH_CHARS];
+
+volatile bool Debugger::abortPollDue = true;
+bool Debugger::abortPollInstalled = false;
+
+void (*Debugger::startHandlers[MAX_DEBUGGER_HANDLERS])() = {0};
+void (*Debugger::finishHandlers[MAX_DEBUGGER_HANDLERS])() = {0};
+void (*Debugger::failureHandlers[MAX_DEBUGGER_HANDLERS])(const char* reason) = {0};
+int Debugger::startHandlerCount = 0;
+int Debugger::finishHandlerCount = 0;
+int Debugger::failureHandlerCount = 0;
+
+static ProfileZone writeRCZone("WriteRC");
+
 
 // Function definitions
 
-AssertionException::AssertionException(const char* functionName_, int lineNumber_, const char* message_) {
-    functionName = functionName_;
-    lineNumber = lineNumber_;
-    message = message_;
+// Every piece of debugger text is drawn through here, so it can be profiled
+static void writeCells(const char* text, int row, int col) {
+    ProfileZone::Scope profile(writeRCZone);
+    LCD.WriteRC(text, row, col);
 }
 
 void Debugger::debugFunction(const char* functionName, void (*funcPtr)()) {
+    installAbortPoll();
     inDebugger = true;
 
     setFontColor();
     clear();
+    scrollbackTotal = 0;
 
     LCD.Clear(backgroundColor);
+    forgetScreen();
     LCD.SetFontColor(debuggerFontColor);
     LCD.WriteRC("Abort", 13, 21);
     printLine(0, "Debugger: %s", functionName);
@@ -48,97 +79,148 @@ void Debugger::debugFunction(const char* functionName, void (*funcPtr)()) {
 
     printLine(12, "");
 
-    try {
+    ProfileZone::resetAll();
+    for (int i = 0; i < startHandlerCount; i++) {
+        (*startHandlers[i])();
+    }
+
+    char failureReason[FAILURE_REASON_SIZE] = "";
+    // abort() and fail() longjmp back here, so nothing on the function's stack is unwound
+    //   and nothing is allocated. Whatever state it left the robot in is cleaned up below.
+    outcome = Completed;
+    if (setjmp(runExit) == 0) {
+        running = true;
         abortCheck();
         (*funcPtr)();
+    }
+    running = false;
+
+    if (outcome == Completed) {
         printLine(12, "Completed. Touch to close.");
-    } catch (AbortException* e) {
+    } else if (outcome == Aborted) {
         setFontColor(errorColor);
         printLine(12, "Aborted. Touch to bruh.");
-        delete e;
-    } catch (AssertionException* e) {
+        Format::print(failureReason, FAILURE_REASON_SIZE, "Aborted in %s", functionName);
+    } else {
         setFontColor(errorColor);
         printLine(9, "Assertion Failed at");
-        printLine(10, "line %i in %s", e->lineNumber, e->functionName);
-        printLine(11, "%s", e->message);
+        printLine(10, "line %i in %s", failedLine, failedFunction);
+        printLine(11, "%s", failedMessage);
         printLine(12, "Touch to close.");
-        delete e;
+        Format::print(failureReason, FAILURE_REASON_SIZE, "Assertion failed at line %i in %s: %s",
+                      failedLine, failedFunction, failedMessage);
     }
 
     Motors::stop();
 
+    if (failureReason[0] != '\0') {
+        for (int i = 0; i < failureHandlerCount; i++) {
+            (*failureHandlers[i])(failureReason);
+        }
+    }
+
+    for (int i = 0; i < finishHandlerCount; i++) {
+        (*finishHandlers[i])();
+    }
+
+    // The Abort button becomes the way into the scrollback
+    LCD.SetFontColor(backgroundColor);
+    LCD.FillRectangle(12*21, 17*13, 12*5, 17);
+    LCD.SetFontColor(defaultFontColor);
+    LCD.WriteRC("Log", 13, 22);
+
     // if pressed, wait until release
     while (LCD.Touch(&x, &y));
     
-    waitUntilPressAndRelease(NULL, NULL);
+    waitUntilPressAndRelease(&x, &y);
+    if (x > 240 && y > 200) {
+        viewScrollback();
+    }
 
     inDebugger = false;
 }
 
+// A handler that didn't fit would silently never run, so a full list is a bug in the app's
+//   setup: raise MAX_DEBUGGER_HANDLERS
+bool Debugger::addStartHandler(void (*handler)()) {
+    assert(startHandlerCount < MAX_DEBUGGER_HANDLERS);
+    if (startHandlerCount >= MAX_DEBUGGER_HANDLERS) return false;
+    startHandlers[startHandlerCount] = handler;
+    startHandlerCount++;
+    return true;
+}
+
+bool Debugger::addFinishHandler(void (*handler)()) {
+    assert(finishHandlerCount < MAX_DEBUGGER_HANDLERS);
+    if (finishHandlerCount >= MAX_DEBUGGER_HANDLERS) return false;
+    finishHandlers[finishHandlerCount] = handler;
+    finishHandlerCount++;
+    return true;
+}
+
+bool Debugger::addFailureHandler(void (*handler)(const char* reason)) {
+    assert(failureHandlerCount < MAX_DEBUGGER_HANDLERS);
+    if (failureHandlerCount >= MAX_DEBUGGER_HANDLERS) return false;
+    failureHandlers[failureHandlerCount] = handler;
+    failureHandlerCount++;
+    return true;
+}
+
 
-void Debugger::printLine(int row, const char* format, ...) {
+void Debugger::printLineList(int row, const char* format, FormatArgList args) {
     if (!inDebugger || row < 0 || row >= HEIGHT_CHARS) return;
-    va_list valist;
-    va_start(valist, format);
-    vsnprintf(debuggerText[row], WIDTH_CHARS, format, valist);
-    LCD.SetFontColor(backgroundColor);
-    LCD.FillRectangle(0, row*17, 320, 17);
-    LCD.SetFontColor(debuggerFontColor);
-    LCD.WriteRC(debuggerText[row], row, 0);
-    va_end(valist);
+    Format::printList(debuggerText[row], WIDTH_CHARS, format, args);
+    rowLines[row] = -1;
+    drawRow(row);
 }
 
-void Debugger::printAppend(int row, const char* format, ...) {
+void Debugger::printAppendList(int row, const char* format, FormatArgList args) {
     if (!inDebugger || row < 0 || row >= HEIGHT_CHARS) return;
-    va_list valist;
-    va_start(valist, format);
-    LCD.SetFontColor(debuggerFontColor);
-    int currentLength = strlen(debuggerText[row]);
-    vsnprintf(debuggerText[row] + currentLength, WIDTH_CHARS - currentLength, format, valist);
-    LCD.WriteRC(debuggerText[row], row, 0);
-    va_end(valist);
+    int currentLength = (int) strlen(debuggerText[row]);
+    Format::printList(debuggerText[row] + currentLength, WIDTH_CHARS - currentLength, format, args);
+    if (rowLines[row] >= oldestScrollbackLine()) {
+        strcpy(scrollback[rowLines[row] % SCROLLBACK_LINES], debuggerText[row]);
+    }
+    drawRow(row);
 }
 
-int Debugger::printNextLine(const char* format, ...) {
+int Debugger::printNextLineList(const char* format, FormatArgList args) {
     if (!inDebugger) return -1;
-    va_list valist;
-    va_start(valist, format);
-    LCD.SetFontColor(debuggerFontColor);
-    int row = -1;
-    for (int i = 0; i < HEIGHT_CHARS; i++) {
-        if (strlen(debuggerText[i]) == 0) {
-            row = i;
-            vsnprintf(debuggerText[row], WIDTH_CHARS, format, valist);
-            LCD.WriteRC(debuggerText[row], row, 0);
-            break;
+
+    // Only the scrollback is written until a row is found, so once the screen is full this
+    //   costs no more than the formatting
+    int line = scrollbackTotal;
+    char* text = scrollback[line % SCROLLBACK_LINES];
+    Format::printList(text, WIDTH_CHARS, format, args);
+    scrollbackColors[line % SCROLLBACK_LINES] = debuggerFontColor;
+    scrollbackTotal++;
+
+    for (int row = 0; row < HEIGHT_CHARS; row++) {
+        if (strlen(debuggerText[row]) == 0) {
+            strcpy(debuggerText[row], text);
+            rowLines[row] = line;
+            drawRow(row);
+            return row;
         }
     }
-    va_end(valist);
-    return row;
+    return -1;
 }
 
-void Debugger::printWrap(int startRow, const char* format, ...) {
+void Debugger::printWrapList(int startRow, const char* format, FormatArgList args) {
     if (!inDebugger || startRow < 0 || startRow >= HEIGHT_CHARS) return;
 
     char buf[WIDTH_CHARS*HEIGHT_CHARS + 1];
-    va_list valist;
-    va_start(valist, format);
-
-    vsnprintf(buf, WIDTH_CHARS*HEIGHT_CHARS, format, valist);
+    Format::printList(buf, WIDTH_CHARS*HEIGHT_CHARS, format, args);
 
     char* bufPos = buf;
     int currentRow = startRow;
     while (currentRow < HEIGHT_CHARS && strlen(bufPos) > 0) {
         strncpy(debuggerText[currentRow], bufPos, WIDTH_CHARS);
-        LCD.SetFontColor(backgroundColor);
-        LCD.FillRectangle(0, currentRow*17, 320, 17);
-        LCD.SetFontColor(debuggerFontColor);
-        LCD.WriteRC(debuggerText[currentRow], currentRow, 0);
+        rowLines[currentRow] = -1;
+        drawRow(currentRow);
         bufPos += strlen(debuggerText[currentRow]);
         currentRow++;
     }
-    
-    va_end(valist);
 }
 
 void Debugger::setFontColor(int color) {
@@ -155,6 +237,129 @@ void Debugger::clear() {
     }
 }
 
+int Debugger::oldestScrollbackLine() {
+    return scrollbackTotal > SCROLLBACK_LINES ? scrollbackTotal - SCROLLBACK_LINES : 0;
+}
+
+bool Debugger::saveScrollback(const char* fileName) {
+    FEHFile* file = SD.FOpen(fileName, "w");
+    if (file == NULL) return false;
+    for (int line = oldestScrollbackLine(); line < scrollbackTotal; line++) {
+        SD.FPrintf(file, "%s\n", scrollback[line % SCROLLBACK_LINES]);
+    }
+    SD.FClose(file);
+    return true;
+}
+
+void Debugger::viewScrollback() {
+    // Rows 0 to 11 show the scrollback and row 12 has the buttons, each a quarter of the
+    //   screen wide. Only characters that change are redrawn, so scrolling is quick.
+    const int viewRows = HEIGHT_CHARS - 1;
+    LCD.SetFontColor(backgroundColor);
+    LCD.FillRectangle(12*21, 17*13, 12*5, 17);
+
+    int oldest = oldestScrollbackLine();
+    int top = scrollbackTotal - viewRows;
+    if (top < oldest) top = oldest;
+    bool saved = false;
+    bool saveFailed = false;
+
+    while (true) {
+        for (int row = 0; row < viewRows; row++) {
+            int line = top + row;
+            if (line < scrollbackTotal) {
+                setFontColor(scrollbackColors[line % SCROLLBACK_LINES]);
+                printLine(row, "%s", scrollback[line % SCROLLBACK_LINES]);
+            } else {
+                printLine(row, "");
+            }
+        }
+        setFontColor();
+        if (saved) {
+            printLine(12, "Saved to %s", SCROLLBACK_FILE);
+        } else if (saveFailed) {
+            setFontColor(errorColor);
+            printLine(12, "Could not save");
+            setFontColor();
+        } else {
+            printLine(12, "%-8s%-6s%-7s%s", " Up", "Down", "Save", "Close");
+        }
+        saved = false;
+        saveFailed = false;
+
+        float x, y;
+        waitUntilPressAndRelease(&x, &y);
+        if (y < 17*viewRows) continue;
+
+        if (x < 80) {
+            top -= SCROLLBACK_STEP;
+            if (top < oldest) top = oldest;
+        } else if (x < 160) {
+            top += SCROLLBACK_STEP;
+            if (top > scrollbackTotal - viewRows) top = scrollbackTotal - viewRows;
+            if (top < oldest) top = oldest;
+        } else if (x < 240) {
+            saved = saveScrollback(SCROLLBACK_FILE);
+            saveFailed = !saved;
+        } else {
+            return;
+        }
+    }
+}
+
+void Debugger::forgetScreen() {
+    // Marking every cell as holding something that can't be printed makes the next draw of
+    //   each row erase and rewrite all of it
+    for (int row = 0; row < HEIGHT_CHARS; row++) {
+        for (int col = 0; col < WIDTH_CHARS; col++) {
+            shownText[row][col] = '\0';
+            shownColors[row][col] = backgroundColor;
+        }
+    }
+}
+
+void Debugger::drawRow(int row) {
+    // The row as it should look, padded out with spaces
+    char wanted[WIDTH_CHARS];
+    int length = (int) strlen(debuggerText[row]);
+    for (int col = 0; col < WIDTH_CHARS; col++) {
+        wanted[col] = col < length ? debuggerText[row][col] : ' ';
+    }
+
+    // Redraw each run of cells that differ from what is shown. A run only needs erasing if
+    //   something was drawn there, and only needs writing if it has something to show.
+    int col = 0;
+    while (col < WIDTH_CHARS) {
+        int start = col;
+        bool erase = false;
+        bool write = false;
+        while (col < WIDTH_CHARS && (wanted[col] != shownText[row][col] ||
+               (wanted[col] != ' ' && shownColors[row][col] != debuggerFontColor))) {
+            if (shownText[row][col] != ' ') erase = true;
+            if (wanted[col] != ' ') write = true;
+            shownText[row][col] = wanted[col];
+            shownColors[row][col] = debuggerFontColor;
+            col++;
+        }
+        if (col == start) {
+            col++;
+            continue;
+        }
+
+        if (erase) {
+            LCD.SetFontColor(backgroundColor);
+            LCD.FillRectangle(12*start, 17*row, 12*(col - start), 17);
+        }
+        if (write) {
+            char run[WIDTH_CHARS + 1];
+            memcpy(run, wanted + start, (size_t) (col - start));
+            run[col - start] = '\0';
+            LCD.SetFontColor(debuggerFontColor);
+            writeCells(run, row, start);
+        }
+    }
+}
+
 void Debugger::breakpoint() {
     if (!inDebugger) return;
     float x, y;
@@ -165,7 +370,7 @@ void Debugger::breakpoint() {
     printLine(12, "");
 
     if (x > 240 && y > 200) {
-        throw new AbortException();
+        abort();
     }
 }
 
@@ -185,7 +390,7 @@ bool Debugger::breakpoint(float timeout) {
     bool timedOut = TimeNow() >= targetTime;
 
     if (!timedOut && x > 240 && y > 200) {
-        throw new AbortException();
+        abort();
     }
 
     return timedOut;
@@ -193,13 +398,42 @@ bool Debugger::breakpoint(float timeout) {
 
 
 void Debugger::abortCheck() {
+    // Reading the touch controller is slow, so only do it when the ticker says it's time. If the
+    //   ticker couldn't be used, abortPollDue is never cleared and every call reads the screen.
+    if (!abortPollDue) return;
+    if (abortPollInstalled) abortPollDue = false;
+
     if (!inDebugger) return;
     float x, y;
     if (LCD.Touch(&x, &y) && x > 240 && y > 200) {
-        throw new AbortException();
+        abort();
     }
 }
 
+void Debugger::abort() {
+    if (!running) ::abort();
+    outcome = Aborted;
+    longjmp(runExit, 1);
+}
+
+void Debugger::fail(const char* functionName, int lineNumber, const char* message) {
+    if (!running) ::abort();
+    outcome = AssertionFailed;
+    failedFunction = functionName;
+    failedLine = lineNumber;
+    failedMessage = message;
+    longjmp(runExit, 1);
+}
+
+void Debugger::installAbortPoll() {
+    if (abortPollInstalled) return;
+    abortPollInstalled = Ticker::addTask(&requestAbortPoll, ABORT_POLL_PERIOD_MS);
+}
+
+void Debugger::requestAbortPoll() {
+    abortPollDue = true;
+}
+
 void Debugger::sleep(float time) {
     double targetTime = TimeNow() + time;
     while (TimeNow() < targetTime) {
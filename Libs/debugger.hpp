@@ -1,7 +1,9 @@
 #ifndef DEBUGGER_HPP
 #define DEBUGGER_HPP
 
-#include "exception"
+#include "setjmp.h"
+
+#include "format.hpp"
 
 
 #define WIDTH_CHARS 26
@@ -9,18 +11,27 @@
 
 #define BUFFER_SIZE 30
 
+// How often abortCheck() actually reads the touch screen, in milliseconds
+#define ABORT_POLL_PERIOD_MS 20
 
-#define assertTrue(condition, message)  if (!(condition)) { throw new AssertionException(__func__, __LINE__, message); }
+// Handlers of each kind (start, finish, failure) that can be registered
+#define MAX_DEBUGGER_HANDLERS 8
 
+// Longest description passed to failure handlers, including the terminator
+#define FAILURE_REASON_SIZE 80
 
-struct AbortException : public std::exception {};
+// Lines printed with printNextLine() that are kept for scrolling back through after a run.
+//   Each takes WIDTH_CHARS + 5 bytes of RAM.
+#define SCROLLBACK_LINES 384
 
-struct AssertionException : public std::exception {
-    const char* functionName;
-    int lineNumber;
-    const char* message;
-    AssertionException(const char* functionName, int lineNumber, const char* message);
-};
+// Lines the scrollback viewer moves per touch of Up or Down
+#define SCROLLBACK_STEP 6
+
+// File on the SD card the scrollback is saved to from the viewer
+#define SCROLLBACK_FILE "CONSOLE.TXT"
+
+
+#define assertTrue(condition, message)  if (!(condition)) { Debugger::fail(__func__, __LINE__, message); }
 
 
 class Debugger {
@@ -39,17 +50,34 @@ public:
 
     // Functions //
 
+    // The print functions take the same format strings and arguments as printf, and format
+    //   them with Format::print().
+
     // Writes text on the specified line, overwriting any text that was previously there.
-    static void printLine(int row, const char* format, ...);
+    template <typename... Args>
+    static void printLine(int row, const char* format, const Args&... args) {
+        printLineList(row, format, FormatArgs<Args...>(args...));
+    }
 
     // Appends text at the end of the specified line.
-    static void printAppend(int row, const char* format, ...);
+    template <typename... Args>
+    static void printAppend(int row, const char* format, const Args&... args) {
+        printAppendList(row, format, FormatArgs<Args...>(args...));
+    }
 
     // Writes the specified text on the first empty line, and returns the line number that was written to.
-    static int printNextLine(const char* format, ...);
+    //   Every line is also kept in the scrollback, even once the screen is full (-1 is returned
+    //   then), and can be looked through by touching "Log" after the run.
+    template <typename... Args>
+    static int printNextLine(const char* format, const Args&... args) {
+        return printNextLineList(format, FormatArgs<Args...>(args...));
+    }
 
     // Writes text on the specified line, with any overflow wrapping to the next lines.
-    static void printWrap(int startRow, const char* format, ...);
+    template <typename... Args>
+    static void printWrap(int startRow, const char* format, const Args&... args) {
+        printWrapList(startRow, format, FormatArgs<Args...>(args...));
+    }
 
     // Change the font color used by the debugger
     static void setFontColor(int color);
@@ -60,6 +88,11 @@ public:
     // Erases everything that has been printed to the screen.
     static void clear();
 
+    // Lines are redrawn one changed character at a time, based on what the debugger last drew
+    //   there. Call this after drawing over the debugger's lines some other way, so the next
+    //   print to each line redraws all of it.
+    static void forgetScreen();
+
     // Prompts the user to press the screen to continue, and pauses execution until they do so.
     static void breakpoint();
 
@@ -68,25 +101,107 @@ public:
     static bool breakpoint(float timeout);
 
     // If the function you want to debug has a busy loop, call this function every loop to enable use
-    //   of the Abort button.
+    //   of the Abort button. The touch screen is only read every ABORT_POLL_PERIOD_MS, so calling
+    //   this is nearly free the rest of the time.
     static void abortCheck();
 
     // If the function you want to debug must wait for an amount of time, use this instead of 
     //   FEHUtility's Sleep() to enable use of the Abort button.
     static void sleep(float time);
 
+    // Ends the function running in the debugger, as if the Abort button had been pressed.
+    //   Control jumps straight back to debugFunction() with longjmp, without unwinding, and
+    //   skipping a non-trivial destructor that way is undefined behavior. So no object with a
+    //   destructor may be alive across anything that can abort: abortCheck(), sleep(),
+    //   breakpoint(), assertTrue, or any function that calls them (every movement in
+    //   navigation.hpp does). Time such code with LoopMonitor::begin() and end() rather than
+    //   a Scope, and put cleanup that must happen in a finish handler. The motors are stopped
+    //   when the jump lands. Outside the debugger, this calls ::abort().
+    [[noreturn]] static void abort();
+
+    // Ends the function running in the debugger with a failed assertion. Used by assertTrue;
+    //   behaves like abort() otherwise, including the rule about destructors.
+    [[noreturn]] static void fail(const char* functionName, int lineNumber, const char* message);
+
     // Waits until the screen is pressed and released, and outputs the last position before the screen
     //   was released. x and y can be null if you do not need the position.
     static void waitUntilPressAndRelease(float* x, float* y);
 
+    // Writes every line in the scrollback to a file on the SD card, oldest first. Returns false
+    //   if the file couldn't be opened.
+    static bool saveScrollback(const char* fileName);
+
     // Runs a function in the debugger. Used internally
     static void debugFunction(const char* functionName, void (*funcPtr)());
 
+    // Registers a function to be called right before each function run in the debugger starts.
+    //   Libraries use this to reset their per-run state. Fails an assertion, or returns false
+    //   when assertions are compiled out, if there are already MAX_DEBUGGER_HANDLERS.
+    static bool addStartHandler(void (*handler)());
+
+    // Registers a function to be called after each function run in the debugger ends, whether it
+    //   completed, aborted, or failed an assertion. The motors are already stopped by then.
+    //   Reports a full list like addStartHandler().
+    static bool addFinishHandler(void (*handler)());
+
+    // Registers a function to be called when a function run in the debugger fails an assertion
+    //   or is aborted, before the finish handlers. It is given a one-line description of what
+    //   happened. Reports a full list like addStartHandler().
+    static bool addFailureHandler(void (*handler)(const char* reason));
+
 
 private:
+    enum RunOutcome {
+        Completed,
+        Aborted,
+        AssertionFailed
+    };
+
     static bool inDebugger;
+
+    // Where abort() and fail() jump back to, and whether it is set (a function is running)
+    static jmp_buf runExit;
+    static bool running;
+    static RunOutcome outcome;
+    static const char* failedFunction;
+    static int failedLine;
+    static const char* failedMessage;
     static char debuggerText[HEIGHT_CHARS][WIDTH_CHARS + 1];
 
+    // What is on the LCD in each character cell, and in what color
+    static char shownText[HEIGHT_CHARS][WIDTH_CHARS];
+    static int shownColors[HEIGHT_CHARS][WIDTH_CHARS];
+
     static int debuggerFontColor;
+
+    // Ring buffer of the lines printed by printNextLine() in this run. Line n (counting from the
+    //   start of the run) is at n % SCROLLBACK_LINES, until it is overwritten.
+    static char scrollback[SCROLLBACK_LINES][WIDTH_CHARS + 1];
+    static int scrollbackColors[SCROLLBACK_LINES];
+    static int scrollbackTotal;
+    // Which scrollback line each row shows, so printAppend() can update it too, or -1
+    static int rowLines[HEIGHT_CHARS];
+
+    // Set by the ticker every ABORT_POLL_PERIOD_MS, and cleared when abortCheck() reads the screen
+    static volatile bool abortPollDue;
+    static bool abortPollInstalled;
+
+    static void (*startHandlers[MAX_DEBUGGER_HANDLERS])();
+    static void (*finishHandlers[MAX_DEBUGGER_HANDLERS])();
+    static void (*failureHandlers[MAX_DEBUGGER_HANDLERS])(const char* reason);
+    static int startHandlerCount;
+    static int finishHandlerCount;
+    static int failureHandlerCount;
+
+    static void printLineList(int row, const char* format, FormatArgList args);
+    static void printAppendList(int row, const char* format, FormatArgList args);
+    static int printNextLineList(const char* format, FormatArgList args);
+    static void printWrapList(int startRow, const char* format, FormatArgList args);
+    static void drawRow(int row);
+    static int oldestScrollbackLine();
+    // Lets the user scroll through the scrollback and save it, until they close it
+    static void viewScrollback();
+    static void installAbortPoll();
+    static void requestAbortPoll();
 };
 #endif
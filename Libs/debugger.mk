@@ -0,0 +1 @@
+debugger_LIBS := assert ticker profiler format
\ No newline at end of file
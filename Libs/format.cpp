@@ -0,0 +1,392 @@
+#include "format.hpp"
+
+#include "math.h"
+#include "stddef.h"
+#include "string.h"
+
+
+// Longest number written before padding: 64 bits in octal is 22 digits, plus a sign
+#define NUMBER_SIZE 24
+
+static const uint32_t powersOfTen[FORMAT_MAX_PRECISION + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+
+// Collects output like snprintf() does: characters past the end of the buffer are only counted.
+struct FormatWriter {
+    char* buf;
+    int size;
+    int length;
+
+    void put(char c) {
+        if (length < size - 1) buf[length] = c;
+        length++;
+    }
+
+    void put(const char* text, int count) {
+        for (int i = 0; i < count; i++) put(text[i]);
+    }
+
+    void pad(char c, int count) {
+        for (int i = 0; i < count; i++) put(c);
+    }
+};
+
+struct FormatSpec {
+    bool leftAlign;
+    bool zeroPad;
+    // Written before positive numbers, or '\0' for none
+    char positiveSign;
+    int width;
+    // -1 if there is none
+    int precision;
+    char conversion;
+};
+
+
+// Function definitions
+
+// Writes the digits of value backwards from end, and returns where they start. The 32-bit loop
+//   is used whenever it can be, since 64-bit division is a library call on the Cortex-M4.
+static char* writeDigits(char* end, uint64_t value, unsigned int base, bool upperCase) {
+    const char* digits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+    char* p = end;
+    while (value > 0xFFFFFFFFu) {
+        *--p = digits[value % base];
+        value /= base;
+    }
+    uint32_t small = (uint32_t) value;
+    do {
+        *--p = digits[small % base];
+        small /= base;
+    } while (small != 0);
+    return p;
+}
+
+// Writes text, which has a sign of signLength characters at its start, padded to the spec's
+//   width. `zeros` more zeros go between the sign and the rest, and with zeroPad, so does the
+//   padding.
+static void writePadded(FormatWriter& out, const FormatSpec& spec, const char* text, int length,
+                        int signLength, int zeros, bool zeroPad) {
+    int padding = spec.width > length + zeros ? spec.width - length - zeros : 0;
+    if (!spec.leftAlign && !zeroPad) out.pad(' ', padding);
+    out.put(text, signLength);
+    out.pad('0', zeros);
+    if (!spec.leftAlign && zeroPad) out.pad('0', padding);
+    out.put(text + signLength, length - signLength);
+    if (spec.leftAlign) out.pad(' ', padding);
+}
+
+// Gets an argument as a signed or unsigned integer the way printf would see it, truncating
+//   floats. 32-bit arguments are reinterpreted at 32 bits, so e.g. -1 in hex is ffffffff.
+static bool integerValue(const FormatArg& arg, bool isSigned, uint64_t* magnitude, bool* negative) {
+    int64_t value;
+    switch (arg.kind) {
+        case FormatArg::Signed:
+            value = isSigned ? arg.i64 : (int64_t) (uint32_t) arg.i64;
+            break;
+        case FormatArg::Unsigned:
+            value = isSigned ? (int64_t) (int32_t) arg.u64 : (int64_t) arg.u64;
+            break;
+        case FormatArg::Signed64:
+        case FormatArg::Unsigned64:
+            value = arg.i64;
+            break;
+        case FormatArg::Float:
+            value = (int64_t) arg.f;
+            break;
+        case FormatArg::Pointer:
+            value = (int64_t) (uintptr_t) arg.p;
+            break;
+        default:
+            return false;
+    }
+
+    *negative = isSigned && value < 0;
+    *magnitude = *negative ? 0 - (uint64_t) value : (uint64_t) value;
+    return true;
+}
+
+static bool floatValue(const FormatArg& arg, double* value) {
+    switch (arg.kind) {
+        case FormatArg::Signed:
+        case FormatArg::Signed64:
+            *value = (double) arg.i64;
+            return true;
+        case FormatArg::Unsigned:
+        case FormatArg::Unsigned64:
+            *value = (double) arg.u64;
+            return true;
+        case FormatArg::Float:
+            *value = arg.f;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void writeInteger(FormatWriter& out, const FormatSpec& spec, const FormatArg& arg) {
+    bool isSigned = spec.conversion == 'd' || spec.conversion == 'i';
+    uint64_t magnitude;
+    bool negative;
+    if (!integerValue(arg, isSigned, &magnitude, &negative)) {
+        out.put('?');
+        return;
+    }
+
+    unsigned int base = 10;
+    if (spec.conversion == 'x' || spec.conversion == 'X') base = 16;
+    if (spec.conversion == 'o') base = 8;
+
+    char number[NUMBER_SIZE];
+    char* end = number + NUMBER_SIZE;
+    char* start = end;
+    // Like printf, a precision of 0 writes nothing at all for 0
+    if (magnitude != 0 || spec.precision != 0) {
+        start = writeDigits(end, magnitude, base, spec.conversion == 'X');
+    }
+    // The precision is the minimum number of digits
+    int digitCount = (int) (end - start);
+    int zeros = spec.precision > digitCount ? spec.precision - digitCount : 0;
+    int signLength = 0;
+    if (negative) {
+        *--start = '-';
+        signLength = 1;
+    } else if (isSigned && spec.positiveSign != '\0') {
+        *--start = spec.positiveSign;
+        signLength = 1;
+    }
+    // Also like printf, the 0 flag is ignored when there is a precision
+    writePadded(out, spec, start, (int) (end - start), signLength, zeros,
+                spec.zeroPad && spec.precision < 0);
+}
+
+static void writeFloat(FormatWriter& out, const FormatSpec& spec, const FormatArg& arg) {
+    double value;
+    if (!floatValue(arg, &value)) {
+        out.put('?');
+        return;
+    }
+
+    int precision = spec.precision < 0 ? 6 : spec.precision;
+    if (precision > FORMAT_MAX_PRECISION) precision = FORMAT_MAX_PRECISION;
+
+    // signbit() rather than value < 0, so -0.0 keeps its sign like it does in printf
+    bool negative = signbit(value);
+    if (negative) value = -value;
+
+    const char* special = NULL;
+    if (isnan(value)) {
+        special = "nan";
+    } else if (value >= FORMAT_FLOAT_LIMIT) {
+        special = isinf(value) ? "inf" : "ovf";
+    }
+
+    char number[NUMBER_SIZE];
+    char* end = number + NUMBER_SIZE;
+    char* start = end;
+    if (special != NULL) {
+        start -= 3;
+        memcpy(start, special, 3);
+    } else {
+        // Round once, in fixed point, so a carry out of the fraction reaches the whole part
+        uint32_t whole = (uint32_t) value;
+        uint32_t scale = powersOfTen[precision];
+        uint32_t fraction = (uint32_t) ((value - (double) whole) * (double) scale + 0.5);
+        if (fraction >= scale) {
+            fraction -= scale;
+            whole++;
+        }
+
+        if (precision > 0) {
+            for (int i = 0; i < precision; i++) {
+                *--start = (char) ('0' + fraction % 10);
+                fraction /= 10;
+            }
+            *--start = '.';
+        }
+        start = writeDigits(start, whole, 10, false);
+    }
+
+    int signLength = 0;
+    if (negative) {
+        *--start = '-';
+        signLength = 1;
+    } else if (spec.positiveSign != '\0') {
+        *--start = spec.positiveSign;
+        signLength = 1;
+    }
+    writePadded(out, spec, start, (int) (end - start), signLength, 0,
+                spec.zeroPad && special == NULL);
+}
+
+static void writeString(FormatWriter& out, const FormatSpec& spec, const FormatArg& arg) {
+    const char* text = arg.kind == FormatArg::String ? arg.s : "?";
+    if (text == NULL) text = "(null)";
+
+    int length = 0;
+    while (text[length] != '\0' && (spec.precision < 0 || length < spec.precision)) length++;
+    writePadded(out, spec, text, length, 0, 0, false);
+}
+
+static void writeChar(FormatWriter& out, const FormatSpec& spec, const FormatArg& arg) {
+    uint64_t magnitude;
+    bool negative;
+    char c = '?';
+    if (integerValue(arg, true, &magnitude, &negative)) {
+        c = (char) (negative ? 0 - magnitude : magnitude);
+    }
+    writePadded(out, spec, &c, 1, 0, 0, false);
+}
+
+static void writePointer(FormatWriter& out, const FormatSpec& spec, const FormatArg& arg) {
+    uint64_t magnitude;
+    bool negative;
+    if (!integerValue(arg, false, &magnitude, &negative)) {
+        out.put('?');
+        return;
+    }
+
+    char number[NUMBER_SIZE];
+    char* end = number + NUMBER_SIZE;
+    char* start = writeDigits(end, magnitude, 16, false);
+    *--start = 'x';
+    *--start = '0';
+    writePadded(out, spec, start, (int) (end - start), 0, 0, false);
+}
+
+int Format::printList(char* buf, int size, const char* format, FormatArgList args) {
+    FormatWriter out = { buf, size, 0 };
+    int next = 0;
+
+    const char* f = format;
+    while (*f != '\0') {
+        if (*f != '%') {
+            out.put(*f++);
+            continue;
+        }
+        f++;
+        if (*f == '%') {
+            out.put('%');
+            f++;
+            continue;
+        }
+
+        FormatSpec spec = { false, false, '\0', 0, -1, '\0' };
+        for (; *f != '\0' && strchr("-0+ #", *f) != NULL; f++) {
+            if (*f == '-') spec.leftAlign = true;
+            if (*f == '0') spec.zeroPad = true;
+            if (*f == '+') spec.positiveSign = '+';
+            if (*f == ' ' && spec.positiveSign == '\0') spec.positiveSign = ' ';
+        }
+        for (; *f >= '0' && *f <= '9'; f++) {
+            spec.width = 10*spec.width + (*f - '0');
+        }
+        if (*f == '.') {
+            f++;
+            spec.precision = 0;
+            for (; *f >= '0' && *f <= '9'; f++) {
+                spec.precision = 10*spec.precision + (*f - '0');
+            }
+        }
+        while (*f != '\0' && strchr("hlLqjzt", *f) != NULL) f++;
+
+        spec.conversion = *f;
+        if (spec.conversion == '\0') break;
+        f++;
+
+        if (next >= args.count) {
+            out.put('?');
+            continue;
+        }
+        const FormatArg& arg = args.args[next++];
+
+        switch (spec.conversion) {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+                writeInteger(out, spec, arg);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+                writeFloat(out, spec, arg);
+                break;
+            case 's':
+                writeString(out, spec, arg);
+                break;
+            case 'c':
+                writeChar(out, spec, arg);
+                break;
+            case 'p':
+                writePointer(out, spec, arg);
+                break;
+            default:
+                out.put('?');
+                break;
+        }
+    }
+
+    if (size > 0) {
+        buf[out.length < size - 1 ? out.length : size - 1] = '\0';
+    }
+    return out.length;
+}
+
+static const char* skipSpaces(const char* text) {
+    while (*text == ' ') text++;
+    return text;
+}
+
+// Skips past an optional sign, and returns whether it was a minus.
+static bool parseSign(const char** p) {
+    bool negative = **p == '-';
+    if (**p == '-' || **p == '+') (*p)++;
+    return negative;
+}
+
+bool Format::parseInt(const char* text, int* value) {
+    const char* p = skipSpaces(text);
+    bool negative = parseSign(&p);
+
+    // The largest magnitude an int can hold with this sign
+    uint32_t limit = negative ? 0x80000000u : 0x7FFFFFFFu;
+    uint32_t magnitude = 0;
+    const char* digitsStart = p;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        uint32_t digit = (uint32_t) (*p - '0');
+        if (magnitude > (limit - digit) / 10) return false;
+        magnitude = 10*magnitude + digit;
+    }
+    if (p == digitsStart || *skipSpaces(p) != '\0') return false;
+
+    *value = negative ? (int) (0 - magnitude) : (int) magnitude;
+    return true;
+}
+
+bool Format::parseFloat(const char* text, float* value) {
+    const char* p = skipSpaces(text);
+    bool negative = parseSign(&p);
+
+    bool any = false;
+    double whole = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        whole = 10*whole + (*p - '0');
+        any = true;
+    }
+
+    // Digits past FORMAT_MAX_PRECISION are too small to change a float, and are skipped
+    uint32_t fraction = 0;
+    int scale = 0;
+    if (*p == '.') {
+        for (p++; *p >= '0' && *p <= '9'; p++) {
+            if (scale < FORMAT_MAX_PRECISION) {
+                fraction = 10*fraction + (uint32_t) (*p - '0');
+                scale++;
+            }
+            any = true;
+        }
+    }
+    if (!any || *skipSpaces(p) != '\0') return false;
+
+    double result = whole + (double) fraction / (double) powersOfTen[scale];
+    *value = (float) (negative ? -result : result);
+    return true;
+}
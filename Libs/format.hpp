@@ -0,0 +1,107 @@
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+#include "stdint.h"
+
+
+// Most digits written after the decimal point; larger precisions are cut down to this
+#define FORMAT_MAX_PRECISION 9
+
+// Floats at or beyond this size (either sign) are written as "ovf", since the whole part is
+//   converted with 32-bit integer math
+#define FORMAT_FLOAT_LIMIT 4.0e9
+
+
+// One argument to a formatting call, along with the type it was given as. The constructors are
+//   implicit, so any argument that printf would take converts to one of these.
+class FormatArg {
+public:
+
+    enum Kind {
+        None,
+        Signed,
+        Unsigned,
+        Signed64,
+        Unsigned64,
+        Float,
+        String,
+        Pointer
+    };
+
+    constexpr FormatArg() : kind(None), i64(0) {}
+    constexpr FormatArg(int value) : kind(Signed), i64(value) {}
+    constexpr FormatArg(unsigned int value) : kind(Unsigned), u64(value) {}
+    // long is 32 bits on the robot, but not on every host
+    constexpr FormatArg(long value) : kind(sizeof(long) > 4 ? Signed64 : Signed), i64(value) {}
+    constexpr FormatArg(unsigned long value) : kind(sizeof(long) > 4 ? Unsigned64 : Unsigned), u64(value) {}
+    constexpr FormatArg(long long value) : kind(Signed64), i64(value) {}
+    constexpr FormatArg(unsigned long long value) : kind(Unsigned64), u64(value) {}
+    constexpr FormatArg(double value) : kind(Float), f(value) {}
+    constexpr FormatArg(const char* value) : kind(String), s(value) {}
+    constexpr FormatArg(const void* value) : kind(Pointer), p(value) {}
+
+    Kind kind;
+    union {
+        int64_t i64;
+        uint64_t u64;
+        double f;
+        const char* s;
+        const void* p;
+    };
+};
+
+
+// The arguments of one formatting call.
+struct FormatArgList {
+    const FormatArg* args;
+    int count;
+};
+
+// Holds the arguments of a formatting call while it runs. Formatting functions that take
+//   `const Args&... args` pass FormatArgs<Args...>(args...) on to a function taking a
+//   FormatArgList, so only that one function is compiled for every set of argument types.
+template <typename... Args>
+class FormatArgs {
+public:
+    FormatArgs(const Args&... values) : args{FormatArg(values)..., FormatArg()} {}
+
+    operator FormatArgList() const {
+        return FormatArgList{args, (int) sizeof...(Args)};
+    }
+
+private:
+    // One extra, so the array isn't empty when there are no arguments
+    FormatArg args[sizeof...(Args) + 1];
+};
+
+
+// A small replacement for snprintf() and sscanf(), so the robot doesn't have to link newlib's
+//   floating point printf and scanf. Format strings are printf's, with these differences:
+//   - Arguments carry their own types, so length modifiers (h, l, ll, z...) are ignored, and an
+//     argument of the wrong type is converted instead of read as garbage.
+//   - Floats are written with at most FORMAT_MAX_PRECISION decimals and rounded half away from
+//     zero. %e and %g are written like %f. Floats of FORMAT_FLOAT_LIMIT or more are "ovf".
+//   - The # flag and * widths aren't supported.
+//   A missing argument or an unknown conversion is written as "?".
+class Format {
+public:
+
+    // Like snprintf(): writes at most size - 1 characters and a terminator, and returns the
+    //   length the whole text would have had.
+    template <typename... Args>
+    static int print(char* buf, int size, const char* format, const Args&... args) {
+        return printList(buf, size, format, FormatArgs<Args...>(args...));
+    }
+
+    // The same, for functions that take their own arguments (see FormatArgs).
+    static int printList(char* buf, int size, const char* format, FormatArgList args);
+
+    // Reads a decimal integer, with an optional sign, that takes up the whole text except for
+    //   spaces around it. Returns false, leaving *value alone, if the text isn't one.
+    static bool parseInt(const char* text, int* value);
+
+    // Like parseInt(), for a decimal number with an optional fractional part, e.g. "-1.25".
+    static bool parseFloat(const char* text, float* value);
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef FRAME_HPP
+#define FRAME_HPP
+
+#include "stdint.h"
+#include "string.h"
+
+
+// Framing for binary messages over a byte stream, shared by the robot and the host tools.
+//
+//   A5 5A <type> <length> <payload: length bytes> <CRC low> <CRC high>
+//
+// The CRC is CRC-16/CCITT-FALSE over the type, length and payload. A receiver that joins
+//   mid-stream, or loses a byte, finds the next frame by looking for the sync bytes again,
+//   and the CRC rejects anything that only looked like a frame.
+
+#define FRAME_SYNC1 0xA5
+#define FRAME_SYNC2 0x5A
+
+#define FRAME_MAX_PAYLOAD 64
+
+// Sync bytes, type, length and CRC
+#define FRAME_OVERHEAD 6
+
+#define FRAME_MAX_SIZE (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+// Frame types
+#define FRAME_TYPE_TELEMETRY 1
+
+
+// Adds data to a running CRC-16/CCITT-FALSE. Start with 0xFFFF. Bitwise rather than
+//   table-driven, to save 512 bytes of flash; about 8 shifts per byte.
+inline uint16_t frameCrc(const uint8_t* data, int length, uint16_t crc = 0xFFFF) {
+    for (int i = 0; i < length; i++) {
+        crc = (uint16_t) (crc ^ (data[i] << 8));
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Writes a frame holding the payload into out, which must have room for length +
+//   FRAME_OVERHEAD bytes. Returns the size of the frame, or 0 if the payload is too long.
+inline int encodeFrame(uint8_t type, const void* payload, int length, uint8_t* out) {
+    if (length < 0 || length > FRAME_MAX_PAYLOAD) return 0;
+    out[0] = FRAME_SYNC1;
+    out[1] = FRAME_SYNC2;
+    out[2] = type;
+    out[3] = (uint8_t) length;
+    memcpy(out + 4, payload, (size_t) length);
+    uint16_t crc = frameCrc(out + 2, length + 2);
+    out[4 + length] = (uint8_t) (crc & 0xFF);
+    out[5 + length] = (uint8_t) (crc >> 8);
+    return length + FRAME_OVERHEAD;
+}
+
+
+// Finds frames in a stream of bytes, one byte at a time.
+class FrameDecoder {
+public:
+
+    FrameDecoder() : state(WaitSync1), type(0), length(0), received(0), crc(0), badFrames(0) {}
+
+    // Takes the next byte of the stream. Returns true if it completed a frame with a good
+    //   CRC, which can then be read with getType(), getLength() and getPayload() until the
+    //   next call.
+    bool feed(uint8_t byte) {
+        switch (state) {
+        case WaitSync1:
+            if (byte == FRAME_SYNC1) state = WaitSync2;
+            return false;
+        case WaitSync2:
+            if (byte == FRAME_SYNC2) {
+                state = ReadType;
+            } else if (byte != FRAME_SYNC1) {
+                state = WaitSync1;
+            }
+            return false;
+        case ReadType:
+            type = byte;
+            state = ReadLength;
+            return false;
+        case ReadLength:
+            if (byte > FRAME_MAX_PAYLOAD) {
+                badFrames++;
+                state = WaitSync1;
+                return false;
+            }
+            length = byte;
+            received = 0;
+            state = length > 0 ? ReadPayload : ReadCrcLow;
+            return false;
+        case ReadPayload:
+            payload[received++] = byte;
+            if (received == length) state = ReadCrcLow;
+            return false;
+        case ReadCrcLow:
+            crc = byte;
+            state = ReadCrcHigh;
+            return false;
+        case ReadCrcHigh: {
+            crc = (uint16_t) (crc | (byte << 8));
+            state = WaitSync1;
+            uint8_t header[2] = {type, (uint8_t) length};
+            uint16_t expected = frameCrc(payload, length, frameCrc(header, 2));
+            if (crc != expected) {
+                badFrames++;
+                return false;
+            }
+            return true;
+        }
+        }
+        return false;
+    }
+
+    uint8_t getType() const { return type; }
+    int getLength() const { return length; }
+    const uint8_t* getPayload() const { return payload; }
+
+    // How many frames were thrown away for a bad CRC or length.
+    uint32_t getBadFrames() const { return badFrames; }
+
+
+private:
+    enum State { WaitSync1, WaitSync2, ReadType, ReadLength, ReadPayload, ReadCrcLow, ReadCrcHigh };
+
+    State state;
+    uint8_t type;
+    int length;
+    int received;
+    uint16_t crc;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint32_t badFrames;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef FRAMEQUEUE_HPP
+#define FRAMEQUEUE_HPP
+
+#include "stdint.h"
+
+#include "frame.hpp"
+#include "spsc.hpp"
+
+
+// Where a FrameQueue's bytes go. canWrite() says whether writeByte() can take a byte right
+//   now without waiting. Both are called from whatever calls drain(), e.g. an interrupt.
+struct ByteTransport {
+    bool (*canWrite)();
+    void (*writeByte)(uint8_t byte);
+};
+
+
+// Frames (see frame.hpp) waiting to be sent over a ByteTransport. The main program queues
+//   whole frames with send(), and drain() hands their bytes to the transport whenever it has
+//   room, so sending never waits on the transport. If the queue is too full for a frame, the
+//   frame is dropped rather than sent in part, so the receiver never sees half of one.
+//
+// Capacity is in bytes and must be a power of two. Header-only with no firmware
+//   dependencies, so Tools/tlmrecv can run the same code the robot does.
+template <uint32_t Capacity>
+class FrameQueue {
+public:
+
+    // Producer side. Queues one frame. Returns false if it was dropped, because the payload
+    //   was too long or there wasn't room for all of it.
+    bool send(uint8_t type, const void* payload, int length) {
+        uint8_t frame[FRAME_MAX_SIZE];
+        int size = encodeFrame(type, payload, length, frame);
+        if (size == 0 || bytes.capacity() - bytes.size() < (uint32_t) size) {
+            droppedFrames++;
+            return false;
+        }
+        for (int i = 0; i < size; i++) {
+            bytes.push(frame[i]);
+        }
+        return true;
+    }
+
+    // Consumer side. Writes up to maxBytes queued bytes to the transport, stopping early if
+    //   it has no room or the queue runs out.
+    void drain(const ByteTransport& transport, int maxBytes) {
+        uint8_t byte;
+        for (int i = 0; i < maxBytes; i++) {
+            if (!(*transport.canWrite)()) return;
+            if (!bytes.pop(&byte)) return;
+            (*transport.writeByte)(byte);
+        }
+    }
+
+    bool empty() const {
+        return bytes.empty();
+    }
+
+    // How many frames send() has dropped.
+    uint32_t getDroppedFrames() const {
+        return droppedFrames;
+    }
+
+private:
+    SpscQueue<uint8_t, Capacity> bytes;
+    // Only written by the producer
+    uint32_t droppedFrames = 0;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include "stdint.h"
+
+
+// Each power of two is split into this many buckets, so a bucket is at most 1/4 of its value
+//   wide (about 12% error around the middle of a bucket).
+#define HISTOGRAM_SUB_BUCKETS 4
+// Enough buckets for any 32-bit value
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_BUCKETS * 31)
+
+
+// A fixed-size histogram of unsigned 32-bit values (e.g. durations in microseconds) with
+//   logarithmically sized buckets. Recording a value is a handful of integer operations and
+//   never allocates, so it can be used inside control loops. Percentiles are approximate:
+//   they return the upper edge of the bucket the percentile falls in.
+class LogHistogram {
+public:
+
+    void record(uint32_t value) {
+        counts[bucketOf(value)]++;
+        total++;
+        if (value > largest) largest = value;
+    }
+
+    void clear() {
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++) counts[i] = 0;
+        total = 0;
+        largest = 0;
+    }
+
+    uint32_t count() const {
+        return total;
+    }
+
+    // The largest value recorded (exact, not bucketed).
+    uint32_t max() const {
+        return largest;
+    }
+
+    // Returns an upper bound for the given percentile, e.g. 0.99 for p99. Returns 0 if nothing
+    //   has been recorded.
+    uint32_t percentile(float fraction) const {
+        if (total == 0) return 0;
+        uint32_t target = (uint32_t) (fraction * (float) total);
+        if (target >= total) target = total - 1;
+
+        uint32_t seen = 0;
+        for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > target) {
+                uint32_t edge = upperEdgeOf(i);
+                // Never report more than we actually saw
+                return edge < largest ? edge : largest;
+            }
+        }
+        return largest;
+    }
+
+    // Number of values recorded in a bucket, and the range of values that bucket holds. Used
+    //   for printing the whole distribution.
+    uint32_t bucketCount(int bucket) const {
+        return counts[bucket];
+    }
+
+    static uint32_t lowerEdgeOf(int bucket) {
+        if (bucket < 2 * HISTOGRAM_SUB_BUCKETS) return (uint32_t) bucket;
+        int exponent = bucket / HISTOGRAM_SUB_BUCKETS + 1;
+        uint32_t step = 1u << (exponent - 2);
+        return (1u << exponent) + step * (uint32_t) (bucket % HISTOGRAM_SUB_BUCKETS);
+    }
+
+    static uint32_t upperEdgeOf(int bucket) {
+        if (bucket + 1 >= HISTOGRAM_BUCKETS) return 0xFFFFFFFFu;
+        return lowerEdgeOf(bucket + 1) - 1;
+    }
+
+
+private:
+    uint32_t counts[HISTOGRAM_BUCKETS] = {};
+    uint32_t total = 0;
+    uint32_t largest = 0;
+
+    // Values below 8 get a bucket each. Above that, a value with its top bit at position e
+    //   goes in one of HISTOGRAM_SUB_BUCKETS buckets chosen by the next two bits.
+    static int bucketOf(uint32_t value) {
+        if (value < 2 * HISTOGRAM_SUB_BUCKETS) return (int) value;
+        int exponent = 31 - __builtin_clz(value);
+        int sub = (int) ((value >> (exponent - 2)) & (HISTOGRAM_SUB_BUCKETS - 1));
+        return (exponent - 1) * HISTOGRAM_SUB_BUCKETS + sub;
+    }
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "loopmonitor.hpp"
+
+#include "assert.hpp"
+#include "cycles.hpp"
+#include "debugger.hpp"
+#include "format.hpp"
+
+#include "stddef.h"
+
+#include "FEHLCD.h"
+
+
+// Static variable definitions
+
+LoopMonitor* LoopMonitor::monitors[MAX_LOOP_MONITORS] = {0};
+int LoopMonitor::monitorCount = 0;
+
+
+// Function definitions
+
+LoopMonitor::LoopMonitor(const char* name_, uint32_t budgetUs_) {
+    name = name_;
+    budgetUs = budgetUs_;
+    budgetCycles = CycleCounter::fromMicros(budgetUs_);
+    startCycles = 0;
+    running = false;
+    lastBeginCycles = 0;
+    begunBefore = false;
+    overruns = 0;
+    intervalTotalUs = 0;
+
+    CycleCounter::start();
+
+    // A monitor that didn't fit would never be reset or reported: raise MAX_LOOP_MONITORS
+    assert(monitorCount < MAX_LOOP_MONITORS);
+    if (monitorCount >= MAX_LOOP_MONITORS) return;
+    // The first monitor hooks every monitor into the debugger
+    if (monitorCount == 0) {
+        Debugger::addStartHandler(&resetAll);
+    }
+    monitors[monitorCount] = this;
+    monitorCount++;
+}
+
+void LoopMonitor::begin() {
+    startCycles = CycleCounter::now();
+    running = true;
+
+    if (begunBefore) {
+        uint32_t intervalUs = CycleCounter::toMicros(startCycles - lastBeginCycles);
+        if (intervalUs <= LOOP_MONITOR_GAP_US) {
+            intervals.record(intervalUs);
+            intervalTotalUs += intervalUs;
+        }
+    }
+    lastBeginCycles = startCycles;
+    begunBefore = true;
+}
+
+void LoopMonitor::end() {
+    if (!running) return;
+    running = false;
+    uint32_t elapsed = CycleCounter::now() - startCycles;
+    durations.record(CycleCounter::toMicros(elapsed));
+    if (elapsed > budgetCycles) overruns++;
+}
+
+void LoopMonitor::reset() {
+    running = false;
+    begunBefore = false;
+    overruns = 0;
+    durations.clear();
+    intervals.clear();
+    intervalTotalUs = 0;
+}
+
+const char* LoopMonitor::getName() const {
+    return name;
+}
+
+uint32_t LoopMonitor::getBudgetUs() const {
+    return budgetUs;
+}
+
+uint32_t LoopMonitor::getIterations() const {
+    return durations.count();
+}
+
+uint32_t LoopMonitor::getOverruns() const {
+    return overruns;
+}
+
+uint32_t LoopMonitor::getWorstUs() const {
+    return durations.max();
+}
+
+uint32_t LoopMonitor::getPercentileUs(float fraction) const {
+    return durations.percentile(fraction);
+}
+
+uint32_t LoopMonitor::getRateHz() const {
+    if (intervalTotalUs == 0) return 0;
+    return (uint32_t) ((uint64_t) intervals.count() * 1000000 / intervalTotalUs);
+}
+
+uint32_t LoopMonitor::getIntervals() const {
+    return intervals.count();
+}
+
+uint32_t LoopMonitor::getIntervalPercentileUs(float fraction) const {
+    return intervals.percentile(fraction);
+}
+
+int LoopMonitor::count() {
+    return monitorCount;
+}
+
+const LoopMonitor* LoopMonitor::get(int i) {
+    if (i < 0 || i >= monitorCount) return NULL;
+    return monitors[i];
+}
+
+void LoopMonitor::resetAll() {
+    for (int i = 0; i < monitorCount; i++) {
+        monitors[i]->reset();
+    }
+}
+
+void LoopMonitor::drawReport() {
+    char buf[BUFFER_SIZE + 1];
+
+    // Three lines per monitor:
+    //   movement  n=1234 over=3
+    //    p99=640 max=812/500us
+    //    812Hz 1023/1279/2047us
+    // The last line is the achieved rate and the p50/p90/p99 time between iterations.
+    for (int i = 0; i < monitorCount && i < 3; i++) {
+        LoopMonitor* m = monitors[i];
+        int y = 40 + 64*i;
+
+        Format::print(buf, BUFFER_SIZE, "%-9s n=%lu over=%lu", m->name,
+                      (unsigned long) m->getIterations(), (unsigned long) m->overruns);
+        LCD.WriteAt(buf, 4, y);
+
+        Format::print(buf, BUFFER_SIZE, " p99=%lu max=%lu/%luus",
+                      (unsigned long) m->getPercentileUs(0.99f), (unsigned long) m->getWorstUs(),
+                      (unsigned long) m->budgetUs);
+        LCD.WriteAt(buf, 4, y + 20);
+
+        Format::print(buf, BUFFER_SIZE, " %luHz %lu/%lu/%luus", (unsigned long) m->getRateHz(),
+                      (unsigned long) m->getIntervalPercentileUs(0.5f),
+                      (unsigned long) m->getIntervalPercentileUs(0.9f),
+                      (unsigned long) m->getIntervalPercentileUs(0.99f));
+        LCD.WriteAt(buf, 4, y + 40);
+    }
+
+    if (monitorCount == 0) {
+        LCD.WriteAt("No loops monitored.", 16, 40);
+    }
+}
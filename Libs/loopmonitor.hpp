@@ -0,0 +1,98 @@
+#ifndef LOOPMONITOR_HPP
+#define LOOPMONITOR_HPP
+
+#include "stdint.h"
+
+#include "histogram.hpp"
+
+
+#define MAX_LOOP_MONITORS 8
+
+// Time between two begin() calls above which the loop is taken to have stopped and started
+//   again (e.g. between two movements), rather than to have run one slow iteration. Such
+//   gaps are left out of the interval stats.
+#define LOOP_MONITOR_GAP_US 100000
+
+
+// Watches one periodic loop: how long each iteration takes, how often an iteration goes over
+//   its time budget, and how steadily iterations start (the time from one begin() to the next,
+//   which gives the rate the loop actually achieves and its jitter). Declare one as a static
+//   object next to the loop, and it registers itself so its stats can be shown on the ProteOS
+//   "Loops" report. Stats are reset at the start of every function run in the debugger, so
+//   the report always covers the last run.
+//
+// Timing uses the DWT cycle counter, so begin() and end() cost a few loads and stores plus a
+//   histogram update.
+class LoopMonitor {
+public:
+
+    // name must be a string literal (or otherwise live forever). budgetUs is the longest an
+    //   iteration may take before it counts as an overrun.
+    LoopMonitor(const char* name, uint32_t budgetUs);
+
+    // Call at the start and end of the part of each iteration you want timed.
+    void begin();
+    void end();
+
+    // Calls begin() when constructed and end() when destroyed, for loops with several
+    //   continue statements or early exits. Only for loops that can't abort the debugger run
+    //   (see Debugger::abort()); loops that sleep or move must call begin() and end().
+    class Scope {
+    public:
+        Scope(LoopMonitor& monitor) : monitor(monitor) { monitor.begin(); }
+        ~Scope() { monitor.end(); }
+    private:
+        LoopMonitor& monitor;
+    };
+
+    void reset();
+
+    const char* getName() const;
+    uint32_t getBudgetUs() const;
+    uint32_t getIterations() const;
+    uint32_t getOverruns() const;
+    uint32_t getWorstUs() const;
+    uint32_t getPercentileUs(float fraction) const;
+
+    // Iterations per second, from the average time between begin() calls. 0 until two
+    //   iterations have run back to back.
+    uint32_t getRateHz() const;
+
+    // Time between begin() calls: how many were measured, and their percentiles (e.g. 0.99
+    //   for p99). The spread between p50 and p99 is the loop's jitter.
+    uint32_t getIntervals() const;
+    uint32_t getIntervalPercentileUs(float fraction) const;
+
+    // The registered monitors, for code that reports on all of them.
+    static int count();
+    static const LoopMonitor* get(int i);
+
+    // Resets every monitor.
+    static void resetAll();
+
+    // Draws every monitor's stats, for use with ProteOS::registerReport().
+    static void drawReport();
+
+
+private:
+    const char* name;
+    uint32_t budgetUs;
+    uint32_t budgetCycles;
+    uint32_t startCycles;
+    bool running;
+    // When the previous iteration began, if there was one since the last reset
+    uint32_t lastBeginCycles;
+    bool begunBefore;
+
+    uint32_t overruns;
+    // Iteration durations in microseconds
+    LogHistogram durations;
+    // Times between begin() calls in microseconds, and their sum
+    LogHistogram intervals;
+    uint64_t intervalTotalUs;
+
+    static LoopMonitor* monitors[MAX_LOOP_MONITORS];
+    static int monitorCount;
+};
+
+#endif
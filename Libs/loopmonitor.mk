@@ -0,0 +1 @@
+loopmonitor_LIBS := assert debugger format
\ No newline at end of file
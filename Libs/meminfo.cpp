@@ -0,0 +1,117 @@
+#include "meminfo.hpp"
+
+#include "debugger.hpp"
+#include "format.hpp"
+
+#include "FEHLCD.h"
+#include "FEHSD.h"
+
+
+// The Vector Table Offset Register. The first word of the vector table is the initial stack
+//   pointer (ARMv7-M Architecture Reference Manual, B1.5.3 and B3.2.5).
+static const uint32_t vectorTableOffset = 0xE000ED08;
+
+
+// Static variable definitions
+
+uint32_t MemInfo::stackTop = 0;
+uint32_t MemInfo::paintBottom = 0;
+uint32_t MemInfo::paintTop = 0;
+
+uint32_t MemInfo::heapStart = 0;
+uint32_t MemInfo::heapBreak = 0;
+uint32_t MemInfo::heapPeakBreak = 0;
+
+uint32_t MemInfo::stackLowest = 0;
+
+// Paints the stack while static objects are constructed, before main() runs
+static struct StackPainter {
+    StackPainter() { MemInfo::paintStack(); }
+} stackPainter;
+
+
+// Function definitions
+
+// The linker sends every call to _sbrk here instead (-Wl,--wrap=_sbrk in meminfo.mk), and
+//   the original becomes __real__sbrk
+extern "C" void* __real__sbrk(ptrdiff_t increment);
+
+extern "C" void* __wrap__sbrk(ptrdiff_t increment) {
+    return MemInfo::sbrk(increment);
+}
+
+void* MemInfo::sbrk(ptrdiff_t increment) {
+    void* previous = __real__sbrk(increment);
+    if (previous == (void*) -1) return previous;
+
+    uint32_t previousBreak = (uint32_t) (uintptr_t) previous;
+    if (heapStart == 0) heapStart = previousBreak;
+    heapBreak = previousBreak + (uint32_t) increment;
+    if (heapBreak > heapPeakBreak) heapPeakBreak = heapBreak;
+    return previous;
+}
+
+void MemInfo::paintStack() {
+    uint32_t vectorTable = *(volatile uint32_t*) vectorTableOffset;
+    stackTop = *(volatile uint32_t*) (uintptr_t) vectorTable;
+
+    // Asking for no memory just reads the current break
+    sbrk(0);
+
+    uint32_t stackPointer = (uint32_t) (uintptr_t) __builtin_frame_address(0);
+    paintBottom = (heapBreak + 3) & ~3u;
+    paintTop = (stackPointer - STACK_PAINT_MARGIN) & ~3u;
+    stackLowest = stackPointer;
+    if (paintBottom >= paintTop) return;
+
+    for (uint32_t address = paintBottom; address < paintTop; address += 4) {
+        *(volatile uint32_t*) (uintptr_t) address = STACK_PAINT;
+    }
+}
+
+uint32_t MemInfo::getStackPeak() {
+    if (stackTop == 0) return 0;
+
+    // Anything below the heap's peak may have been painted over by the heap, and anything
+    //   above stackLowest is already known to be used, so only scan in between
+    uint32_t address = paintBottom;
+    if (heapPeakBreak > address) address = (heapPeakBreak + 3) & ~3u;
+    uint32_t end = stackLowest < paintTop ? stackLowest : paintTop;
+    while (address < end && *(volatile uint32_t*) (uintptr_t) address == STACK_PAINT) {
+        address += 4;
+    }
+    if (address < end) stackLowest = address;
+
+    return stackTop - stackLowest;
+}
+
+uint32_t MemInfo::getHeapUsed() {
+    return heapBreak - heapStart;
+}
+
+uint32_t MemInfo::getHeapPeak() {
+    return heapPeakBreak - heapStart;
+}
+
+uint32_t MemInfo::getMinFree() {
+    getStackPeak();
+    return stackLowest > heapPeakBreak ? stackLowest - heapPeakBreak : 0;
+}
+
+void MemInfo::drawReport() {
+    char buf[BUFFER_SIZE + 1];
+
+    Format::print(buf, BUFFER_SIZE, "Stack peak: %lu B", (unsigned long) getStackPeak());
+    LCD.WriteAt(buf, 16, 40);
+    Format::print(buf, BUFFER_SIZE, "Heap now:   %lu B", (unsigned long) getHeapUsed());
+    LCD.WriteAt(buf, 16, 64);
+    Format::print(buf, BUFFER_SIZE, "Heap peak:  %lu B", (unsigned long) getHeapPeak());
+    LCD.WriteAt(buf, 16, 88);
+    Format::print(buf, BUFFER_SIZE, "Min free:   %lu B", (unsigned long) getMinFree());
+    LCD.WriteAt(buf, 16, 112);
+}
+
+void MemInfo::writeTelemetry(FEHFile* file) {
+    SD.FPrintf(file, "MEM %lu %lu %lu\n", (unsigned long) getStackPeak(),
+               (unsigned long) getHeapPeak(), (unsigned long) getMinFree());
+}
@@ -0,0 +1,73 @@
+#ifndef MEMINFO_HPP
+#define MEMINFO_HPP
+
+#include "stdint.h"
+#include "stddef.h"
+
+#include "FEHSD.h"
+
+
+// Word written over the unused stack at boot
+#define STACK_PAINT 0xC5C5C5C5u
+
+// How far below the stack pointer painting stops, so the painting code's own frame and
+//   anything an interrupt pushes while it runs are left alone
+#define STACK_PAINT_MARGIN 64
+
+
+// Measures how much RAM the stack and heap have used since boot.
+//
+// At boot, the RAM between the end of the heap and the stack pointer is filled with
+//   STACK_PAINT. The deepest the stack has ever gone is then the lowest word that no longer
+//   holds the paint. The heap is tracked by wrapping newlib's _sbrk (see meminfo.mk), which
+//   every malloc and new goes through when it needs more memory.
+//
+// The stack and heap grow towards each other, so the gap left between them (getMinFree()) is
+//   how close the program has come to running out of RAM.
+class MemInfo {
+public:
+
+    // Deepest the stack has been since boot, in bytes below the initial stack pointer.
+    //   Scans the painted area, so it takes a moment; don't call it in a control loop.
+    static uint32_t getStackPeak();
+
+    // Bytes of heap in use now and at most since boot. newlib doesn't give memory back to
+    //   sbrk, so these only grow.
+    static uint32_t getHeapUsed();
+    static uint32_t getHeapPeak();
+
+    // Bytes between the heap's peak and the stack's deepest point. The two peaks may not have
+    //   happened at the same time, so the real smallest gap was at least this big.
+    static uint32_t getMinFree();
+
+    // Draws the stack and heap usage, for use with ProteOS::registerReport().
+    static void drawReport();
+
+    // Writes a "MEM <stack peak> <heap peak> <min free>" line, in bytes. Set
+    //   Telemetry::onFlush to this to add the line to every telemetry file.
+    static void writeTelemetry(FEHFile* file);
+
+    // Fills the unused stack with STACK_PAINT. Called once at boot; do not call directly.
+    static void paintStack();
+
+    // Moves the heap break, recording how far it has gone. Called through the _sbrk wrapper;
+    //   do not call directly.
+    static void* sbrk(ptrdiff_t increment);
+
+
+private:
+    // Where the stack starts (its highest address), from the vector table
+    static uint32_t stackTop;
+    // The painted area; the bottom moves up as the heap grows into it
+    static uint32_t paintBottom;
+    static uint32_t paintTop;
+
+    static uint32_t heapStart;
+    static uint32_t heapBreak;
+    static uint32_t heapPeakBreak;
+
+    // Lowest address the stack is known to have reached
+    static uint32_t stackLowest;
+};
+
+#endif
@@ -0,0 +1,2 @@
+meminfo_LIBS := format
+meminfo_LDFLAGS := -Wl,--wrap=_sbrk
\ No newline at end of file
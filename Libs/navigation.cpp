@@ -7,6 +7,12 @@
 #include "math.h"
 
 #include "debugger.hpp"
+#include "loopmonitor.hpp"
+#include "profiler.hpp"
+#include "telemetry.hpp"
+#include "timeline.hpp"
+#include "tracelog.hpp"
+#include "ticker.hpp"
 
 // why do I have to define this myself this is dumb
 #define M_PI 3.1415926535f
@@ -28,6 +34,10 @@ float Motors::errorThresholdInches = DEFAULT_ERROR_THRESHOLD_INCHES;
 float Motors::tempX = 0;
 float Motors::tempY = 0;
 float Motors::tempH = 0;
+float Motors::lastRpsX = 0;
+float Motors::lastRpsY = 0;
+float Motors::lastRpsH = 0;
+void (*Motors::onMotorCommand)() = NULL;
 
 /* float Motors::qrCodeX = QRCODE_DEFAULT_X;
 float Motors::qrCodeY = QRCODE_DEFAULT_Y;
@@ -38,6 +48,15 @@ FEHMotor Motors::rMotor(RIGHT_MOTOR_PORT, MOTOR_VOLTAGE);
 DigitalEncoder Motors::lEncoder(LEFT_ENCODER_PIN);
 DigitalEncoder Motors::rEncoder(RIGHT_ENCODER_PIN);
 
+static LoopMonitor movementLoop("movement", MOVEMENT_LOOP_BUDGET_US);
+static LoopMonitor lineUpLoop("lineUp", LINE_UP_BUDGET_US);
+static LoopMonitor rpsReads("rpsRead", RPS_READ_BUDGET_US);
+
+static ProfileZone odometryTrigZone("cos/sin");
+static ProfileZone rpsXZone("RPS.X");
+static ProfileZone rpsYZone("RPS.Y");
+static ProfileZone rpsHeadingZone("RPS.Head");
+
 
 // Function definitions
 
@@ -48,6 +67,26 @@ float limitAngle(float a) {
     return a;
 }
 
+void Motors::notifyMotorCommand() {
+    if (onMotorCommand != NULL) (*onMotorCommand)();
+}
+
+void Motors::recordTelemetry(float leftPower, float rightPower, int leftCounts, int rightCounts) {
+    TelemetryRecord r;
+    r.timeMs = Ticker::millis();
+    r.leftCounts = leftCounts;
+    r.rightCounts = rightCounts;
+    r.leftPower = (int16_t) (leftPower * 100);
+    r.rightPower = (int16_t) (rightPower * 100);
+    r.x = tempX;
+    r.y = tempY;
+    r.heading = tempH;
+    r.rpsX = lastRpsX;
+    r.rpsY = lastRpsY;
+    r.rpsHeading = lastRpsH;
+    Telemetry::record(r);
+}
+
 void Motors::calculateMotorPower(float* leftPower, float* rightPower) {
     *leftPower = maxPower;
     *rightPower = maxPower;
@@ -78,6 +117,7 @@ bool Motors::doMovementWithSlowdown(float leftPower, float rightPower, int dista
     rEncoder.ResetCounts();
     lMotor.SetPercent(leftPower);
     rMotor.SetPercent(rightPower);
+    notifyMotorCommand();
 
     // Loop for however many slowdown stages there are. If there are none, this loop will be skipped
     for (int i = 0; i < slowdownStages; i++) {
@@ -86,18 +126,25 @@ bool Motors::doMovementWithSlowdown(float leftPower, float rightPower, int dista
         while ((lEncoder.Counts() + rEncoder.Counts()) / 2 < distanceInCounts - (int)slowdownDistance) {
             Debugger::abortCheck();
             Debugger::sleep(0.001f);
+            movementLoop.begin();
             int lDiff = lEncoder.Counts() - leftCountsPrev;
             int rDiff = rEncoder.Counts() - rightCountsPrev;
             leftCountsPrev = lEncoder.Counts();
             rightCountsPrev = rEncoder.Counts();
             float angleDiff = (rDiff - lDiff) / 2.f / ENCODER_COUNTS_PER_DEGREE;
             float distDiff = (rDiff + lDiff) / 2.f / ENCODER_COUNTS_PER_INCH;
-            tempX += cos(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
-            tempY += sin(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
+            {
+                ProfileZone::Scope profile(odometryTrigZone);
+                tempX += cos(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
+                tempY += sin(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
+            }
             tempH = limitAngle(tempH + angleDiff * RAD_TO_DEG);
+            recordTelemetry(leftPower, rightPower, leftCountsPrev, rightCountsPrev);
+            movementLoop.end();
             
             if (TimeNow() > timeoutTime || TimeNow() > secondTimeoutTime) {
                 Motors::stop();
+                Timeline::noteTimeout();
                 return true;
             }
         }
@@ -118,17 +165,24 @@ bool Motors::doMovementWithSlowdown(float leftPower, float rightPower, int dista
     while ((lEncoder.Counts() + rEncoder.Counts()) / 2 < distanceInCounts) {
         Debugger::abortCheck();
         Debugger::sleep(0.001f);
+        movementLoop.begin();
         int lDiff = lEncoder.Counts() - leftCountsPrev;
         int rDiff = rEncoder.Counts() - rightCountsPrev;
         leftCountsPrev = lEncoder.Counts();
         rightCountsPrev = rEncoder.Counts();
         float angleDiff = (rDiff - lDiff) / 2.f / ENCODER_COUNTS_PER_DEGREE;
         float distDiff = (rDiff + lDiff) / 2.f / ENCODER_COUNTS_PER_INCH;
-        tempX += cos(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
-        tempY += sin(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
+        {
+            ProfileZone::Scope profile(odometryTrigZone);
+            tempX += cos(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
+            tempY += sin(tempH * DEG_TO_RAD + angleDiff / 2) * distDiff;
+        }
         tempH = limitAngle(tempH + angleDiff * RAD_TO_DEG);
+        recordTelemetry(leftPower, rightPower, leftCountsPrev, rightCountsPrev);
+        movementLoop.end();
         if (TimeNow() > timeoutTime || TimeNow() > secondTimeoutTime) {
             Motors::stop();
+            Timeline::noteTimeout();
             return true;
         }
     }
@@ -177,6 +231,7 @@ void Motors::pulse_forward(int percent, float seconds){
     
     lMotor.SetPercent(percent);
     rMotor.SetPercent(percent);
+    notifyMotorCommand();
 
     Sleep(seconds);
 
@@ -189,6 +244,7 @@ void Motors::pulse_counterclockwise(int percent, float seconds)
 {
     lMotor.SetPercent(-percent);
     rMotor.SetPercent(percent);
+    notifyMotorCommand();
 
     Sleep(seconds);
 
@@ -213,6 +269,7 @@ void Motors::start(bool forward) {
 
     lMotor.SetPercent(leftPower);
     rMotor.SetPercent(rightPower);
+    notifyMotorCommand();
 }
 
 void Motors::stop() {
@@ -400,29 +457,32 @@ int Motors::driveToBackwards(float targetX, float targetY, float targetH) {
 // turns the robot to the specified heading using RPS
 void Motors::lineUpToAngle(float targetH) {
 
-    //Debugger::printLine(1, "turning to h = %.1f", targetH);
+    TRACE("turning to h = %.1f", targetH);
 
     float currentH = getH();
     while (abs(limitAngle(targetH - currentH)) > errorThresholdDegrees) {
+        lineUpLoop.begin();
+        Timeline::noteCorrection();
 
-        //Debugger::printLine(2, "targ: %.1f curr: %.1f", targetH, currentH);
-        //Debugger::printLine(3, "error: %.1f", limitAngle(targetH - currentH));
+        TRACE("targ: %.1f curr: %.1f", targetH, currentH);
+        TRACE("error: %.1f", limitAngle(targetH - currentH));
 
         Motors::turn(-limitAngle(targetH - currentH) /* + ((targetH > currentH) ? -3 : 3) */);
         Debugger::sleep(rpsDelay);
         currentH = getH();
+        lineUpLoop.end();
     }
 
-    //Debugger::printLine(2, "targ: %.1f curr: %.1f", targetH, currentH);
-    //Debugger::printLine(3, "error: %.1f", limitAngle(targetH - currentH));
-    //Debugger::printLine(4, "Finished");
+    TRACE("targ: %.1f curr: %.1f", targetH, currentH);
+    TRACE("error: %.1f", limitAngle(targetH - currentH));
+    TRACE("Finished");
 }
 
 // moves the robot along its current facing axis until it reaches the specified x
 //   coordinate. works best if lined up with the x axis
 void Motors::lineUpToXCoordinate(float x) {
 
-    //Debugger::printLine(1, "going to x = %.1f", x);
+    TRACE("going to x = %.1f", x);
 
     // account for how far forward the QR code is on the robot
     float targetX = x + QRCODE_OFFSET * cos(getH() * DEG_TO_RAD);
@@ -430,9 +490,11 @@ void Motors::lineUpToXCoordinate(float x) {
     // repeat until close to the target position
     float currentX = getX();
     while (abs(targetX - currentX) > errorThresholdInches) {
+        lineUpLoop.begin();
+        Timeline::noteCorrection();
 
-        //Debugger::printLine(2, "targ: %.1f curr: %.1f", targetX, currentX);
-        //Debugger::printLine(3, "error: %.1f", abs(targetX - currentX));
+        TRACE("targ: %.1f curr: %.1f", targetX, currentX);
+        TRACE("error: %.1f", abs(targetX - currentX));
 
         // drive towards the target position (accounting for the robot's facing direction)
         Motors::drive((targetX - currentX) / cos(getH() * DEG_TO_RAD));
@@ -441,18 +503,19 @@ void Motors::lineUpToXCoordinate(float x) {
         Debugger::sleep(rpsDelay);
         currentX = getX();
         targetX = x + QRCODE_OFFSET * cos(getH() * DEG_TO_RAD);
+        lineUpLoop.end();
     }
 
-    //Debugger::printLine(2, "targ: %.1f curr: %.1f", targetX, currentX);
-    //Debugger::printLine(3, "error: %.1f", abs(targetX - currentX));
-    //Debugger::printLine(4, "Finished");
+    TRACE("targ: %.1f curr: %.1f", targetX, currentX);
+    TRACE("error: %.1f", abs(targetX - currentX));
+    TRACE("Finished");
 }
 
 // moves the robot along its current facing axis until it reaches the specified y
 //   coordinate. works best if lined up with the y axis
 void Motors::lineUpToYCoordinate(float y) {
 
-    //Debugger::printLine(1, "going to y = %.1f", y);
+    TRACE("going to y = %.1f", y);
 
     // account for how far forward the QR code is on the robot
     float targetY = y + QRCODE_OFFSET * sin(getH() * DEG_TO_RAD);
@@ -460,9 +523,11 @@ void Motors::lineUpToYCoordinate(float y) {
     // repeat until close to the target position
     float currentY = getY();
     while (abs(targetY - currentY) > errorThresholdInches) {
+        lineUpLoop.begin();
+        Timeline::noteCorrection();
 
-        //Debugger::printLine(2, "targ: %.1f curr: %.1f", targetY, currentY);
-        //Debugger::printLine(3, "error: %.1f", abs(targetY - currentY));
+        TRACE("targ: %.1f curr: %.1f", targetY, currentY);
+        TRACE("error: %.1f", abs(targetY - currentY));
 
         // drive towards the target position (accounting for the robot's facing direction)
         Motors::drive((targetY - currentY) / sin(getH() * DEG_TO_RAD));
@@ -471,11 +536,12 @@ void Motors::lineUpToYCoordinate(float y) {
         Debugger::sleep(rpsDelay);
         currentY = getY();
         targetY = y + QRCODE_OFFSET * sin(getH() * DEG_TO_RAD);
+        lineUpLoop.end();
     }
 
-    //Debugger::printLine(2, "targ: %.1f curr: %.1f", targetY, currentY);
-    //Debugger::printLine(3, "error: %.1f", abs(targetY - currentY));
-    //Debugger::printLine(4, "Finished");
+    TRACE("targ: %.1f curr: %.1f", targetY, currentY);
+    TRACE("error: %.1f", abs(targetY - currentY));
+    TRACE("Finished");
 }
 
 void Motors::lineUpToXCoordinateMaintainHeading(float x, float targetH) {
@@ -485,6 +551,9 @@ void Motors::lineUpToXCoordinateMaintainHeading(float x, float targetH) {
     float targetX;
     float currentH = getH();
     for (int i = 0; i < 30; i++) {
+        lineUpLoop.begin();
+        Timeline::noteCorrection();
+
         currentH = getH();
 
         if (abs(limitAngle(targetH - currentH)) > errorThresholdDegrees) {
@@ -495,6 +564,7 @@ void Motors::lineUpToXCoordinateMaintainHeading(float x, float targetH) {
                 Motors::drive((Random.RandInt() % 2) ? -2 : 2);
             }
             Debugger::sleep(rpsDelay);
+            lineUpLoop.end();
             continue;
         }
 
@@ -510,9 +580,11 @@ void Motors::lineUpToXCoordinateMaintainHeading(float x, float targetH) {
                 Motors::drive(correctionDistance > 0 ? -2 : 2);
             }
             Debugger::sleep(rpsDelay);
+            lineUpLoop.end();
             continue;
         }
-        
+
+        lineUpLoop.end();
         break;
     }
 }
@@ -524,6 +596,9 @@ void Motors::lineUpToYCoordinateMaintainHeading(float y, float targetH) {
     float targetY;
     float currentH = getH();
     for (int i = 0; i < 30; i++) {
+        lineUpLoop.begin();
+        Timeline::noteCorrection();
+
         currentH = getH();
 
         if (abs(limitAngle(targetH - currentH)) > errorThresholdDegrees) {
@@ -534,6 +609,7 @@ void Motors::lineUpToYCoordinateMaintainHeading(float y, float targetH) {
                 Motors::drive((Random.RandInt() % 2) ? -2 : 2);
             }
             Debugger::sleep(rpsDelay);
+            lineUpLoop.end();
             continue;
         }
 
@@ -549,15 +625,24 @@ void Motors::lineUpToYCoordinateMaintainHeading(float y, float targetH) {
                 Motors::drive(correctionDistance > 0 ? -2 : 2);
             }
             Debugger::sleep(rpsDelay);
+            lineUpLoop.end();
             continue;
         }
-        
+
+        lineUpLoop.end();
         break;
     }
 }
 
 float Motors::getX() {
-    float rpsX = RPS.X();
+    rpsReads.begin();
+    float rpsX;
+    {
+        ProfileZone::Scope profile(rpsXZone);
+        rpsX = RPS.X();
+    }
+    rpsReads.end();
+    lastRpsX = rpsX;
     if (rpsX >= 0 && rpsX < 36) {
         tempX = rpsX;
         return rpsX;
@@ -567,7 +652,14 @@ float Motors::getX() {
 }
 
 float Motors::getY() {
-    float rpsY = RPS.Y();
+    rpsReads.begin();
+    float rpsY;
+    {
+        ProfileZone::Scope profile(rpsYZone);
+        rpsY = RPS.Y();
+    }
+    rpsReads.end();
+    lastRpsY = rpsY;
     if (rpsY >= 0 && rpsY < 72) {
         tempY = rpsY;
         return rpsY;
@@ -577,7 +669,14 @@ float Motors::getY() {
 }
 
 float Motors::getH() {
-    float rpsH = RPS.Heading();
+    rpsReads.begin();
+    float rpsH;
+    {
+        ProfileZone::Scope profile(rpsHeadingZone);
+        rpsH = RPS.Heading();
+    }
+    rpsReads.end();
+    lastRpsH = rpsH;
     if (rpsH >= 0) {
         tempH = rpsH;
         return rpsH;
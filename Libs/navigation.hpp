@@ -28,6 +28,11 @@
 // The maximum acceptable difference in position while lining up
 #define DEFAULT_ERROR_THRESHOLD_INCHES 0.1f
 
+// Time budgets for the monitored loops, in microseconds (see the Loops report in ProteOS)
+#define MOVEMENT_LOOP_BUDGET_US 500
+#define LINE_UP_BUDGET_US 3000000
+#define RPS_READ_BUDGET_US 1000
+
 class Motors {
 public:
 
@@ -73,6 +78,10 @@ public:
 
     static float errorThresholdDegrees, errorThresholdInches;
 
+    // If set, called every time Motors starts the motors. Used by StartLight to measure how
+    //   long the robot takes to react to the start light.
+    static void (*onMotorCommand)();
+
     // Motors and encoders. These will be given a value before the program starts, so
     //   constructing your own motor or encoder objects is not necessary.
     static FEHMotor lMotor, rMotor;
@@ -139,11 +148,15 @@ public:
 
 private:
     static float tempX, tempY, tempH;
+    // The last raw RPS readings, kept for telemetry
+    static float lastRpsX, lastRpsY, lastRpsH;
 
     static float getX();
     static float getY();
     static float getH();
     static void calculateMotorPower(float* leftPower, float* rightPower);
+    static void notifyMotorCommand();
+    static void recordTelemetry(float leftPower, float rightPower, int leftCounts, int rightCounts);
     static bool doMovementWithSlowdown(float leftPower, float rightPower, int distanceInCounts);
 };
 
@@ -1 +1 @@
-navigation_LIBS := debugger
\ No newline at end of file
+navigation_LIBS := debugger loopmonitor telemetry ticker timeline tracelog
\ No newline at end of file
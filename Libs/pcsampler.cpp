@@ -0,0 +1,102 @@
+#include "pcsampler.hpp"
+
+#include "debugger.hpp"
+#include "ticker.hpp"
+
+#include "FEHSD.h"
+
+
+// Format version of PC_SAMPLER_FILE, read by Tools/pcprof
+#define PC_SAMPLER_VERSION 1
+
+
+// Static variable definitions
+
+uint32_t PcSampler::pcs[PC_SAMPLER_TABLE_SIZE];
+uint32_t PcSampler::counts[PC_SAMPLER_TABLE_SIZE];
+volatile uint32_t PcSampler::samples = 0;
+volatile uint32_t PcSampler::dropped = 0;
+
+
+// Function definitions
+
+void PcSampler::enable() {
+    Debugger::addStartHandler(&startRun);
+    Debugger::addFinishHandler(&finishRun);
+}
+
+void PcSampler::start() {
+    Ticker::setPcSampler(&sample);
+}
+
+void PcSampler::stop() {
+    Ticker::setPcSampler(NULL);
+}
+
+void PcSampler::clear() {
+    for (int i = 0; i < PC_SAMPLER_TABLE_SIZE; i++) {
+        pcs[i] = 0;
+        counts[i] = 0;
+    }
+    samples = 0;
+    dropped = 0;
+}
+
+uint32_t PcSampler::getSamples() {
+    return samples;
+}
+
+uint32_t PcSampler::getDropped() {
+    return dropped;
+}
+
+void PcSampler::sample(uint32_t pc) {
+    samples = samples + 1;
+
+    // Thumb instructions are 2-byte aligned, so drop bit 0 before hashing (Knuth's
+    //   multiplicative hash), then probe linearly
+    uint32_t slot = ((pc >> 1) * 2654435761u) & (PC_SAMPLER_TABLE_SIZE - 1);
+    for (int probe = 0; probe < PC_SAMPLER_MAX_PROBES; probe++) {
+        if (pcs[slot] == pc) {
+            counts[slot]++;
+            return;
+        }
+        if (pcs[slot] == 0) {
+            pcs[slot] = pc;
+            counts[slot] = 1;
+            return;
+        }
+        slot = (slot + 1) & (PC_SAMPLER_TABLE_SIZE - 1);
+    }
+    dropped = dropped + 1;
+}
+
+bool PcSampler::dump() {
+    FEHFile* file = SD.FOpen(PC_SAMPLER_FILE, "w");
+    if (file == NULL) return false;
+
+    SD.FPrintf(file, "PCPROF %i %lu %lu %i\n", PC_SAMPLER_VERSION, (unsigned long) samples,
+               (unsigned long) dropped, TICKER_FREQUENCY_HZ);
+    for (int i = 0; i < PC_SAMPLER_TABLE_SIZE; i++) {
+        if (pcs[i] == 0) continue;
+        SD.FPrintf(file, "%08lx %lu\n", (unsigned long) pcs[i], (unsigned long) counts[i]);
+    }
+
+    SD.FClose(file);
+    return true;
+}
+
+void PcSampler::startRun() {
+    clear();
+    start();
+}
+
+void PcSampler::finishRun() {
+    stop();
+    if (samples == 0) return;
+    if (!dump()) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printNextLine("PC samples not saved");
+        Debugger::setFontColor();
+    }
+}
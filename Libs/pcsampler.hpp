@@ -0,0 +1,64 @@
+#ifndef PCSAMPLER_HPP
+#define PCSAMPLER_HPP
+
+#include "stdint.h"
+
+
+// How many different addresses the sampler can count (must be a power of two). Each takes
+//   8 bytes of RAM.
+#define PC_SAMPLER_TABLE_SIZE 1024
+
+// How many slots are tried before a sample of a new address is dropped
+#define PC_SAMPLER_MAX_PROBES 16
+
+// File on the SD card the samples are written to after each debugger run
+#define PC_SAMPLER_FILE "PCPROF.TXT"
+
+
+// A statistical profiler. On every SysTick tick (TICKER_FREQUENCY_HZ) it records the address
+//   the main program was interrupted at, and counts how often each address was seen. Unlike
+//   ProfileZone, this needs no instrumentation, so it finds hot code nobody thought to measure.
+//
+// The samples are written to PC_SAMPLER_FILE as "<address in hex> <count>" lines. To turn them
+//   into a list of the hottest functions, copy the file off the SD card and run
+//
+//     make tools
+//     Build/Tools/pcprof/pcprof Build/<app>.elf PCPROF.TXT
+//
+// Time spent in the firmware's own interrupt handlers is counted against whatever the main
+//   program was doing when they ran.
+class PcSampler {
+public:
+
+    // Samples during every debugger run, and writes the samples to PC_SAMPLER_FILE after it.
+    static void enable();
+
+    // Start and stop sampling by hand.
+    static void start();
+    static void stop();
+
+    // Throws away every sample. Don't call while sampling.
+    static void clear();
+
+    // How many samples were taken, and how many of those were dropped because the table was
+    //   too full to find a slot.
+    static uint32_t getSamples();
+    static uint32_t getDropped();
+
+    // Writes the samples to PC_SAMPLER_FILE. Returns false if the file couldn't be opened.
+    static bool dump();
+
+
+private:
+    // Addresses and how many times each was sampled; an address of 0 marks an empty slot
+    static uint32_t pcs[PC_SAMPLER_TABLE_SIZE];
+    static uint32_t counts[PC_SAMPLER_TABLE_SIZE];
+    static volatile uint32_t samples;
+    static volatile uint32_t dropped;
+
+    static void sample(uint32_t pc);
+    static void startRun();
+    static void finishRun();
+};
+
+#endif
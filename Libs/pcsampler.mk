@@ -0,0 +1 @@
+pcsampler_LIBS := debugger ticker
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "profiler.hpp"
+
+#include "assert.hpp"
+#include "format.hpp"
+
+#include "FEHLCD.h"
+
+
+// How many zones fit on the report
+#define PROFILE_REPORT_ZONES 4
+
+#define PROFILE_LINE_SIZE 30
+
+
+// Static variable definitions
+
+ProfileZone* ProfileZone::zones[MAX_PROFILE_ZONES] = {0};
+int ProfileZone::zoneCount = 0;
+
+
+// Function definitions
+
+ProfileZone::ProfileZone(const char* name_) {
+    name = name_;
+    reset();
+
+    CycleCounter::start();
+
+    // A zone that didn't fit would never be reset or reported: raise MAX_PROFILE_ZONES
+    assert(zoneCount < MAX_PROFILE_ZONES);
+    if (zoneCount >= MAX_PROFILE_ZONES) return;
+    zones[zoneCount] = this;
+    zoneCount++;
+}
+
+void ProfileZone::add(uint32_t cycles) {
+    calls++;
+    totalCycles += cycles;
+    if (cycles < minCycles) minCycles = cycles;
+    if (cycles > maxCycles) maxCycles = cycles;
+}
+
+void ProfileZone::reset() {
+    calls = 0;
+    totalCycles = 0;
+    minCycles = UINT32_MAX;
+    maxCycles = 0;
+}
+
+const char* ProfileZone::getName() const {
+    return name;
+}
+
+uint32_t ProfileZone::getCalls() const {
+    return calls;
+}
+
+uint64_t ProfileZone::getTotalCycles() const {
+    return totalCycles;
+}
+
+uint32_t ProfileZone::getMinCycles() const {
+    return calls > 0 ? minCycles : 0;
+}
+
+uint32_t ProfileZone::getAverageCycles() const {
+    return calls > 0 ? (uint32_t) (totalCycles / calls) : 0;
+}
+
+uint32_t ProfileZone::getMaxCycles() const {
+    return maxCycles;
+}
+
+void ProfileZone::resetAll() {
+    for (int i = 0; i < zoneCount; i++) {
+        zones[i]->reset();
+    }
+}
+
+void ProfileZone::drawReport() {
+    // Sort the zones by total cycles, most first
+    ProfileZone* sorted[MAX_PROFILE_ZONES];
+    int count = 0;
+    for (int i = 0; i < zoneCount; i++) {
+        if (zones[i]->calls == 0) continue;
+        int j = count;
+        while (j > 0 && sorted[j - 1]->totalCycles < zones[i]->totalCycles) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = zones[i];
+        count++;
+    }
+
+    // Two lines per zone:
+    //   cos/sin   n=1234 38ms
+    //    2301/2716/5120 cyc
+    char buf[PROFILE_LINE_SIZE + 1];
+    for (int i = 0; i < count && i < PROFILE_REPORT_ZONES; i++) {
+        ProfileZone* z = sorted[i];
+        int y = 40 + 48*i;
+
+        Format::print(buf, PROFILE_LINE_SIZE, "%-9s n=%lu %lums", z->name, (unsigned long) z->calls,
+                      (unsigned long) (z->totalCycles / (CORE_CLOCK_HZ / 1000)));
+        LCD.WriteAt(buf, 4, y);
+
+        Format::print(buf, PROFILE_LINE_SIZE, " %lu/%lu/%lu cyc", (unsigned long) z->getMinCycles(),
+                      (unsigned long) z->getAverageCycles(), (unsigned long) z->maxCycles);
+        LCD.WriteAt(buf, 4, y + 20);
+    }
+
+    if (count == 0) {
+        LCD.WriteAt("Nothing profiled.", 16, 40);
+    }
+}
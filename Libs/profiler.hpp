@@ -0,0 +1,76 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "stdint.h"
+
+#include "cycles.hpp"
+
+
+#define MAX_PROFILE_ZONES 16
+
+
+// A named piece of code to count cycles in. Declare one as a static object and put a
+//   ProfileZone::Scope wherever that code runs:
+//
+//     static ProfileZone trigZone("cos/sin");
+//     ...
+//     {
+//         ProfileZone::Scope profile(trigZone);
+//         x += cos(h) * d;
+//     }
+//
+// Zones register themselves so they can be shown on the ProteOS "Profile" report, and are
+//   reset at the start of every function run in the debugger. A scope costs two reads of the
+//   DWT cycle counter plus a few adds and compares, and nested scopes are counted in full by
+//   every zone they are inside.
+//
+// Only use zones from the main program, not from interrupts.
+class ProfileZone {
+public:
+
+    // name must be a string literal (or otherwise live forever).
+    ProfileZone(const char* name);
+
+    // Counts the cycles from its construction to its destruction in a zone. Must not be alive
+    //   across anything that can abort the debugger run (see Debugger::abort()).
+    class Scope {
+    public:
+        Scope(ProfileZone& zone) : zone(zone), startCycles(CycleCounter::now()) {}
+        ~Scope() { zone.add(CycleCounter::now() - startCycles); }
+    private:
+        ProfileZone& zone;
+        uint32_t startCycles;
+    };
+
+    // Adds one call that took the given number of cycles.
+    void add(uint32_t cycles);
+
+    void reset();
+
+    const char* getName() const;
+    uint32_t getCalls() const;
+    uint64_t getTotalCycles() const;
+    uint32_t getMinCycles() const;
+    uint32_t getAverageCycles() const;
+    uint32_t getMaxCycles() const;
+
+    // Resets every zone. Called by the debugger before each run.
+    static void resetAll();
+
+    // Lists the zones that used the most cycles in total, for use with
+    //   ProteOS::registerReport().
+    static void drawReport();
+
+
+private:
+    const char* name;
+    uint32_t calls;
+    uint64_t totalCycles;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+
+    static ProfileZone* zones[MAX_PROFILE_ZONES];
+    static int zoneCount;
+};
+
+#endif
@@ -0,0 +1 @@
+profiler_LIBS := assert format
\ No newline at end of file
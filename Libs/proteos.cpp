@@ -1,13 +1,17 @@
 #include "proteos.hpp"
 
+#include "assert.hpp"
+#include "batterymonitor.hpp"
 #include "debugger.hpp"
+#include "format.hpp"
+#include "navigation.hpp"
+#include "varstore.hpp"
+#include "widgets.hpp"
 
 #include "string.h"
-#include "stdio.h"
 
 #include "FEHLCD.h"
 #include "FEHUtility.h"
-#include "FEHBattery.h"
 #include "FEHRPS.h"
 
 
@@ -18,176 +22,404 @@ int ProteOS::foregroundColor = 0xD0C0FF;
 ProteOS::UIState ProteOS::uiState = UIState::Menu;
 int ProteOS::currentVars = 0;
 int ProteOS::currentFuncs = 0;
+int ProteOS::currentReports = 0;
 int ProteOS::selectedVar = 0;
 int ProteOS::selectedFunc = 0;
+int ProteOS::selectedReport = 0;
+int ProteOS::selectedPreset = 0;
 
-const char* ProteOS::varNames[MAX_VARIABLES] = {0};
-ProteOS::VariableType ProteOS::varTypes[MAX_VARIABLES];
-void* ProteOS::varPtrs[MAX_VARIABLES] = {0};
+const char* ProteOS::appName = NULL;
+const ProteOSVariable* ProteOS::variables = NULL;
+const ProteOSFunction* ProteOS::functions = NULL;
+
+const char* ProteOS::reportNames[MAX_REPORTS] = {0};
+void (*ProteOS::reportDrawFuncs[MAX_REPORTS])() = {0};
+
+
+// Widgets
+
+// The text being typed into a variable, with a cursor under it
+class EditField : public Widget {
+public:
+    char text[BUFFER_SIZE + 1];
+    size_t cursorPos;
+
+    EditField() : Widget(0, 96, 320, 22) {
+        text[0] = '\0';
+        cursorPos = 0;
+    }
+
+    void draw() {
+        LCD.WriteAt(text, 4, 96);
+        LCD.WriteAt("_", 4 + 12*(int) cursorPos, 100);
+    }
+};
+
+static void formatBattery(char* buf, int size) {
+    Format::print(buf, size, "%.2fV", BatteryMonitor::voltage());
+}
+
+static void formatRPSRegion(char* buf, int size) {
+    Format::print(buf, size, "Current Region: %i", RPS.CurrentRegion());
+}
+
+static void formatRPSTime(char* buf, int size) {
+    Format::print(buf, size, "Time left: %i", RPS.Time());
+}
+
+static void formatRPSX(char* buf, int size) {
+    Format::print(buf, size, "X: %.3f", RPS.X());
+}
+
+static void formatRPSY(char* buf, int size) {
+    Format::print(buf, size, "Y: %.3f", RPS.Y());
+}
+
+static void formatRPSHeading(char* buf, int size) {
+    Format::print(buf, size, "Heading: %.3f", RPS.Heading());
+}
+
+// RPS doesn't say when its last reading arrived, so its age is how long the reading has
+//   stayed exactly the same
+static void formatRPSAge(char* buf, int size) {
+    static float last[3] = {0, 0, 0};
+    static double changedTime = 0;
+    float pose[3] = { RPS.X(), RPS.Y(), RPS.Heading() };
+    // Compared bit for bit, since any new reading is different
+    if (memcmp(pose, last, sizeof(pose)) != 0) {
+        memcpy(last, pose, sizeof(pose));
+        changedTime = TimeNow();
+    }
+
+    // The firmware reports these values instead of a position
+    if (pose[0] < -1.5f) {
+        Format::print(buf, size, "Invalid: dead zone");
+    } else if (pose[0] < -0.5f) {
+        Format::print(buf, size, "Invalid: no QR code");
+    } else {
+        Format::print(buf, size, "Valid, %.1fs old", TimeNow() - changedTime);
+    }
+}
+
+static void formatEncoders(char* buf, int size) {
+    Format::print(buf, size, "Enc L: %i R: %i", Motors::lEncoder.Counts(), Motors::rEncoder.Counts());
+}
+
+static Screen screen(ProteOS::backgroundColor, ProteOS::foregroundColor);
+
+// Title bar
+static Button backButton(0, 0, 30, 30, "<", false);
+static Label titleLabel(40, 4, 180);
+static ValueField batteryField(232, 4, 88, &formatBattery, Label::Right);
+static Label titleRule(4, 16, 312, "--------------------------");
+
+// Menu
+static Label nameLabel(118, 112, 84, "ProteOS");
+static Button varsButton(0, 164, 62, 76, "Vars", false);
+static Button funcsButton(64, 164, 62, 76, "Funcs", false);
+static Button rpsButton(128, 164, 62, 76, "RPS", false);
+static Button statsButton(192, 164, 62, 76, "Stats", false);
+static Button presetsButton(256, 164, 62, 76, "Saves", false);
+
+// Lists, and the buttons for paging through them
+static List varList(0, 37, 320, LIST_PAGE_ROWS);
+static List funcList(0, 37, 320, LIST_PAGE_ROWS);
+static List reportList(0, 37, 320, LIST_PAGE_ROWS);
+static List presetList(0, 37, 320, LIST_PAGE_ROWS);
+static Button pageUpButton(0, 208, 80, 32, "^", false);
+static Label pageLabel(130, 215, 60);
+static Button pageDownButton(240, 208, 80, 32, "v", false);
+static Canvas reportCanvas(0, 36, 320, 204);
+
+// A variable, and the keypad for editing it
+static Label varTypeLabel(16, 40, 300);
+static ValueField varValueField(16, 64, 300, NULL);
+static Button editButton(120, 200, 80, 32, "Edit");
+static Label parseErrorLabel(160, 80, 132, "Parse error");
+static Label saveStatusLabel(16, 80, 140);
+static EditField editField;
+static const char digitKeyChars[] = "789456123-0.";
+static Button digitKeys[] = {
+    Button(82, 129, 24, 24, "7", false), Button(106, 129, 24, 24, "8", false), Button(130, 129, 24, 24, "9", false),
+    Button(82, 153, 24, 24, "4", false), Button(106, 153, 24, 24, "5", false), Button(130, 153, 24, 24, "6", false),
+    Button(82, 177, 24, 24, "1", false), Button(106, 177, 24, 24, "2", false), Button(130, 177, 24, 24, "3", false),
+    Button(82, 201, 24, 24, "-", false), Button(106, 201, 24, 24, "0", false), Button(130, 201, 24, 24, ".", false),
+};
+static Button deleteKey(178, 129, 36, 24, "<x", false);
+static Button leftKey(166, 177, 24, 24, "<", false);
+static Button rightKey(214, 177, 24, 24, ">", false);
+static Button enterKey(166, 201, 72, 24, "Enter", false);
+
+// A function
+static Button debugButton(100, 160, 120, 60, "Debug");
+static Label lowBatteryLabel(16, 40, 300);
+
+// A preset
+static Label presetStatusLabel(16, 40, 300);
+static Button saveButton(40, 160, 110, 60, "Save");
+static Button loadButton(170, 160, 110, 60, "Load");
+
+// RPS
+static Label rpsStatusLabel(16, 40, 300);
+static Button connectButton(100, 160, 120, 60, "Connect");
+static ValueField rpsRegionField(16, 64, 300, &formatRPSRegion);
+static ValueField rpsTimeField(16, 88, 300, &formatRPSTime);
+static ValueField rpsXField(16, 112, 300, &formatRPSX);
+static ValueField rpsYField(16, 136, 300, &formatRPSY);
+static ValueField rpsHeadingField(16, 160, 300, &formatRPSHeading);
+static ValueField rpsAgeField(16, 184, 300, &formatRPSAge);
+static ValueField encodersField(16, 208, 300, &formatEncoders);
 
-const char* ProteOS::funcNames[MAX_FUNCTIONS] = {0};
-void (*ProteOS::funcPtrs[MAX_FUNCTIONS])() = {0};
 
 // Function definitions
 
-void ProteOS::registerVariable(const char* variableName, int* varPtr) {
-    if (currentVars >= MAX_VARIABLES) return;
-    varNames[currentVars] = variableName;
-    varTypes[currentVars] = VariableType::Int;
-    varPtrs[currentVars] = varPtr;
-    currentVars++;
+void ProteOS::setVariables(const ProteOSVariable* vars, int count) {
+    variables = vars;
+    currentVars = count;
 }
 
-void ProteOS::registerVariable(const char* variableName, float* varPtr) {
-    if (currentVars >= MAX_VARIABLES) return;
-    varNames[currentVars] = variableName;
-    varTypes[currentVars] = VariableType::Float;
-    varPtrs[currentVars] = varPtr;
-    currentVars++;
+void ProteOS::setAppName(const char* name) {
+    appName = name;
 }
 
-void ProteOS::registerVariable(const char* variableName, bool* varPtr) {
-    if (currentVars >= MAX_VARIABLES) return;
-    varNames[currentVars] = variableName;
-    varTypes[currentVars] = VariableType::Bool;
-    varPtrs[currentVars] = varPtr;
-    currentVars++;
+void ProteOS::setFunctions(const ProteOSFunction* funcs, int count) {
+    functions = funcs;
+    currentFuncs = count;
 }
 
-void ProteOS::registerFunction(const char* functionName, void (*funcPtr)()) {
-    if (currentFuncs >= MAX_FUNCTIONS) return;
-    funcNames[currentFuncs] = functionName;
-    funcPtrs[currentFuncs] = funcPtr;
-    currentFuncs++;
+// A report that didn't fit would never be listed, so a full list is a bug in the app's setup:
+//   raise MAX_REPORTS
+bool ProteOS::registerReport(const char* reportName, void (*drawFunc)()) {
+    assert(currentReports < MAX_REPORTS);
+    if (currentReports >= MAX_REPORTS) return false;
+    reportNames[currentReports] = reportName;
+    reportDrawFuncs[currentReports] = drawFunc;
+    currentReports++;
+    return true;
 }
 
 void ProteOS::run() {
+    // Without a name, the app's presets would land in files no other app could tell apart
+    assert(currentVars == 0 || appName != NULL);
+    VarStore::load(appName, VARSTORE_BOOT_PRESET, variables, currentVars);
+    setupWidgets();
+    drawScreen();
+    screen.redrawAll();
     while (true) {
-        drawScreen();
         waitForInput();
+        drawScreen();
     }
 }
 
-void ProteOS::drawScreen() {
-    LCD.Clear(backgroundColor);
-    LCD.SetFontColor(foregroundColor);
+void ProteOS::setupWidgets() {
+    Widget* widgets[] = {
+        &titleLabel, &batteryField, &titleRule, &backButton,
+        &nameLabel, &varsButton, &funcsButton, &rpsButton, &statsButton, &presetsButton,
+        &varList, &funcList, &reportList, &presetList, &pageUpButton, &pageLabel, &pageDownButton,
+        &reportCanvas,
+        &varTypeLabel, &varValueField, &editButton, &parseErrorLabel, &saveStatusLabel, &editField,
+        &deleteKey, &leftKey, &rightKey, &enterKey,
+        &debugButton, &lowBatteryLabel,
+        &presetStatusLabel, &saveButton, &loadButton,
+        &rpsStatusLabel, &connectButton, &rpsRegionField, &rpsTimeField, &rpsXField, &rpsYField,
+        &rpsHeadingField, &rpsAgeField, &encodersField
+    };
+    // A widget the screen has no room for would never be drawn or touched
+    static_assert(sizeof(widgets) / sizeof(widgets[0]) + sizeof(digitKeys) / sizeof(digitKeys[0])
+                  <= MAX_SCREEN_WIDGETS, "ProteOS has more widgets than MAX_SCREEN_WIDGETS");
+    for (unsigned int i = 0; i < sizeof(widgets) / sizeof(widgets[0]); i++) {
+        bool added = screen.add(widgets[i]);
+        assert(added);
+    }
+    for (unsigned int i = 0; i < sizeof(digitKeys) / sizeof(digitKeys[0]); i++) {
+        bool added = screen.add(&digitKeys[i]);
+        assert(added);
+    }
 
-    char buf[BUFFER_SIZE + 1];
+    varsButton.setIcon(&drawFolderIcon);
+    funcsButton.setIcon(&drawFolderIcon);
+    rpsButton.setIcon(&drawRPSIcon);
+    statsButton.setIcon(&drawFolderIcon);
+    presetsButton.setIcon(&drawFolderIcon);
+
+    varList.setItems(currentVars, &variableName, &formatVariable);
+    funcList.setItems(currentFuncs, &functionName, NULL);
+    reportList.setItems(currentReports, &reportName, NULL);
+    presetList.setItems(VARSTORE_PRESETS, &presetName, &formatPreset);
+    varValueField.setFormatFunction(&formatSelectedVariable);
+
+    parseErrorLabel.setVisible(false);
+    editField.setVisible(false);
+    setKeypadVisible(false);
+}
 
-    LCD.WriteAt("--------------------------", 4, 16);
+void ProteOS::drawScreen() {
+    backButton.setVisible(uiState != UIState::Menu);
+
+    nameLabel.setVisible(uiState == UIState::Menu);
+    varsButton.setVisible(uiState == UIState::Menu);
+    funcsButton.setVisible(uiState == UIState::Menu);
+    rpsButton.setVisible(uiState == UIState::Menu);
+    statsButton.setVisible(uiState == UIState::Menu);
+    presetsButton.setVisible(uiState == UIState::Menu);
+
+    varList.setVisible(uiState == UIState::LookingAtVars);
+    funcList.setVisible(uiState == UIState::LookingAtFuncs);
+    reportList.setVisible(uiState == UIState::LookingAtReports);
+    presetList.setVisible(uiState == UIState::LookingAtPresets);
+    reportCanvas.setVisible(uiState == UIState::ViewingReport);
+
+    List* list = currentList();
+    bool paged = list != NULL && list->getPageCount() > 1;
+    pageUpButton.setVisible(paged);
+    pageLabel.setVisible(paged);
+    pageDownButton.setVisible(paged);
+    if (paged) {
+        pageLabel.setFormat("%i/%i", list->getPage() + 1, list->getPageCount());
+    }
 
-    LCD.WriteAt(Battery.Voltage(), 232, 4);
-    LCD.WriteAt("V", 304, 4);
+    varTypeLabel.setVisible(uiState == UIState::AccessingVar);
+    varValueField.setVisible(uiState == UIState::AccessingVar);
+    editButton.setVisible(uiState == UIState::AccessingVar);
+    saveStatusLabel.setVisible(uiState == UIState::AccessingVar);
+
+    debugButton.setVisible(uiState == UIState::AccessingFunc);
+    // Warn before a run, while there's still time to swap the battery
+    lowBatteryLabel.setVisible(uiState == UIState::AccessingFunc && BatteryMonitor::isLow());
+
+    presetStatusLabel.setVisible(uiState == UIState::AccessingPreset);
+    saveButton.setVisible(uiState == UIState::AccessingPreset);
+    loadButton.setVisible(uiState == UIState::AccessingPreset);
+
+    bool usingRPS = uiState == UIState::UsingRPSNotConnected || uiState == UIState::UsingRPSConnected;
+    rpsStatusLabel.setVisible(usingRPS);
+    connectButton.setVisible(uiState == UIState::UsingRPSNotConnected);
+    rpsRegionField.setVisible(uiState == UIState::UsingRPSConnected);
+    rpsTimeField.setVisible(uiState == UIState::UsingRPSConnected);
+    rpsXField.setVisible(uiState == UIState::UsingRPSConnected);
+    rpsYField.setVisible(uiState == UIState::UsingRPSConnected);
+    rpsHeadingField.setVisible(uiState == UIState::UsingRPSConnected);
+    rpsAgeField.setVisible(uiState == UIState::UsingRPSConnected);
+    encodersField.setVisible(uiState == UIState::UsingRPSConnected);
 
     switch (uiState) {
         case UIState::Menu:
-            LCD.WriteAt("Menu", 40, 4);
-            LCD.WriteAt("ProteOS", 118, 112);
-            LCD.WriteAt("Vars", 10, 220);
-            drawFolderIcon(4, 164);
-            LCD.WriteAt("Funcs", 76, 220);
-            drawFolderIcon(76, 164);
-            LCD.WriteAt("RPS", 160, 220);
-            drawRPSIcon(148, 164);
+            titleLabel.setText("Menu");
             break;
-
         case UIState::LookingAtVars:
-            LCD.WriteAt("<", 4, 4);
-            LCD.WriteAt("Variables", 40, 4);
-            for (int i = 0; i < currentVars; i++) {
-                LCD.WriteAt(varNames[i], 16, 40 + 24*i);
-                switch (varTypes[i]) {
-                    case Bool:
-                        snprintf(buf, BUFFER_SIZE, "%s", *((bool*) varPtrs[i]) ? "true" : "false");
-                        break;
-                    case Int:
-                        snprintf(buf, BUFFER_SIZE, "%i", *((int*) varPtrs[i]));
-                        break;
-                    case Float:
-                        snprintf(buf, BUFFER_SIZE, "%.3f", *((float*) varPtrs[i]));
-                }
-
-                // Cut it off if it's too long
-                if (strlen(buf) > 8) {
-                    strcpy(buf+5, "...");
-                }
-                LCD.WriteAt(buf, 292 - 12*strlen(buf), 40 + 24*i);
-            }
+            titleLabel.setText("Variables");
             break;
         case UIState::LookingAtFuncs:
-            LCD.WriteAt("<", 4, 4);
-            LCD.WriteAt("Functions", 40, 4);
-            for (int i = 0; i < currentFuncs; i++) {
-                LCD.WriteAt(funcNames[i], 16, 40 + 24*i);
-            }
+            titleLabel.setText("Functions");
+            break;
+        case UIState::LookingAtReports:
+            titleLabel.setText("Stats");
+            break;
+        case UIState::ViewingReport:
+            titleLabel.setText(reportNames[selectedReport]);
+            break;
+        case UIState::LookingAtPresets:
+            titleLabel.setText("Presets");
+            break;
+        case UIState::AccessingPreset:
+            titleLabel.setText(presetName(selectedPreset));
             break;
-
         case UIState::AccessingVar:
-            LCD.WriteAt("<", 4, 4);
-            LCD.WriteAt(varNames[selectedVar], 40, 4);
-
-            switch (varTypes[selectedVar]) {
-                case Bool:
-                    LCD.WriteAt("Type: bool", 16, 40);
-                    break;
-                case Int:
-                    LCD.WriteAt("Type: int", 16, 40);
-                    break;
-                case Float:
-                    LCD.WriteAt("Type: float", 16, 40);
+            titleLabel.setText(variables[selectedVar].name);
+            switch (variables[selectedVar].type) {
+                case ProteOSVariable::Bool:
+                    varTypeLabel.setText("Type: bool");
                     break;
-            }
-
-            switch (varTypes[selectedVar]) {
-                case Bool:
-                    snprintf(buf, BUFFER_SIZE, "Value: %s", *((bool*) varPtrs[selectedVar]) ? "true" : "false");
+                case ProteOSVariable::Int:
+                    varTypeLabel.setText("Type: int");
                     break;
-                case Int:
-                    snprintf(buf, BUFFER_SIZE, "Value: %i", *((int*) varPtrs[selectedVar]));
+                case ProteOSVariable::Float:
+                    varTypeLabel.setText("Type: float");
                     break;
-                case Float:
-                    snprintf(buf, BUFFER_SIZE, "Value: %f", *((float*) varPtrs[selectedVar]));
             }
-            LCD.WriteAt(buf, 16, 64);
-
-            LCD.DrawRectangle(120, 200, 80, 32);
-            LCD.WriteAt("Edit", 136, 208);
+            varValueField.refresh();
             break;
-
         case UIState::AccessingFunc:
-            LCD.WriteAt("<", 4, 4);
-            LCD.WriteAt(funcNames[selectedFunc], 40, 4);
-            //LCD.DrawRectangle(20, 160, 120, 60);
-            LCD.DrawRectangle(100, 160, 120, 60);
-            //LCD.WriteAt("Run", 62, 182);
-            LCD.WriteAt("Debug", 130, 182);
+            titleLabel.setText(functions[selectedFunc].name);
+            lowBatteryLabel.setFormat("Battery low: %.2fV", BatteryMonitor::voltage());
             break;
-
         case UIState::UsingRPSNotConnected:
-            LCD.WriteAt("<", 4, 4);
-            LCD.WriteAt("RPS", 40, 4);
-            LCD.WriteAt("RPS not connected.", 16, 40);
-            LCD.DrawRectangle(100, 160, 120, 60);
-            LCD.WriteAt("Connect", 118, 182);
+            titleLabel.setText("RPS");
+            rpsStatusLabel.setText("RPS not connected.");
             break;
-        
         case UIState::UsingRPSConnected:
-            LCD.WriteAt("<", 4, 4);
-            LCD.WriteAt("RPS", 40, 4);
-            LCD.WriteAt("RPS is connected.", 16, 40);
-            LCD.WriteAt("Current Region: ", 16, 64);
-            LCD.WriteAt(RPS.CurrentRegion(), 208, 64);
-            LCD.WriteAt("Time left: ", 16, 88);
-            LCD.WriteAt(RPS.Time(), 148, 88);
-            LCD.WriteAt("X: ", 16, 112);
-            LCD.WriteAt(RPS.X(), 52, 112);
-            LCD.WriteAt("Y: ", 16, 136);
-            LCD.WriteAt(RPS.Y(), 52, 136);
-            LCD.WriteAt("Heading: ", 16, 160);
-            LCD.WriteAt(RPS.Heading(), 124, 160);
+            titleLabel.setText("RPS");
+            rpsStatusLabel.setText("RPS is connected.");
+            rpsRegionField.refresh();
+            rpsTimeField.refresh();
+            rpsXField.refresh();
+            rpsYField.refresh();
+            rpsHeadingField.refresh();
+            rpsAgeField.refresh();
+            encodersField.refresh();
             break;
     }
 
+    batteryField.refresh();
+    screen.paint();
+}
+
+void ProteOS::formatVariable(int i, char* buf, int size) {
+    const ProteOSVariable& var = variables[i];
+    switch (var.type) {
+        case ProteOSVariable::Bool:
+            Format::print(buf, size, "%s", *((bool*) var.ptr) ? "true" : "false");
+            break;
+        case ProteOSVariable::Int:
+            Format::print(buf, size, "%i", *((int*) var.ptr));
+            break;
+        case ProteOSVariable::Float:
+            Format::print(buf, size, "%.3f", *((float*) var.ptr));
+    }
+}
+
+void ProteOS::formatSelectedVariable(char* buf, int size) {
+    const ProteOSVariable& var = variables[selectedVar];
+    switch (var.type) {
+        case ProteOSVariable::Bool:
+            Format::print(buf, size, "Value: %s", *((bool*) var.ptr) ? "true" : "false");
+            break;
+        case ProteOSVariable::Int:
+            Format::print(buf, size, "Value: %i", *((int*) var.ptr));
+            break;
+        case ProteOSVariable::Float:
+            Format::print(buf, size, "Value: %f", *((float*) var.ptr));
+    }
+}
+
+const char* ProteOS::variableName(int i) {
+    return variables[i].name;
+}
+
+const char* ProteOS::functionName(int i) {
+    return functions[i].name;
+}
+
+const char* ProteOS::reportName(int i) {
+    return reportNames[i];
+}
+
+const char* ProteOS::presetName(int i) {
+    static const char* const names[VARSTORE_PRESETS] = { "Boot", "Preset 1", "Preset 2", "Preset 3" };
+    return names[i];
+}
+
+void ProteOS::formatPreset(int i, char* buf, int size) {
+    int count = VarStore::entryCount(appName, i);
+    if (count < 0) {
+        Format::print(buf, size, "-");
+    } else {
+        Format::print(buf, size, "%i vars", count);
+    }
+}
+
+bool ProteOS::saveBootPreset() {
+    return VarStore::save(appName, VARSTORE_BOOT_PRESET, variables, currentVars);
 }
 
 void ProteOS::drawFolderIcon(int x, int y) {
@@ -220,194 +452,297 @@ void ProteOS::drawRPSIcon(int x, int y) {
 
 void ProteOS::waitForInput() {
     float x, y;
-    Debugger::waitUntilPressAndRelease(&x, &y);
+    if (uiState == UIState::UsingRPSConnected) {
+        // Live readings, so the robot can be placed by watching its position
+        refreshUntilPressAndRelease(&x, &y);
+    } else {
+        Debugger::waitUntilPressAndRelease(&x, &y);
+    }
+    Widget* touched = screen.hit(x, y);
+
+    // Paging works the same in every list
+    List* list = currentList();
+    if (touched == &pageUpButton) {
+        list->setPage(list->getPage() - 1);
+        return;
+    } else if (touched == &pageDownButton) {
+        list->setPage(list->getPage() + 1);
+        return;
+    }
 
     switch (uiState) {
         case Menu:
-            if (x < 70 && y > 164) {
+            if (touched == &varsButton) {
                 uiState = UIState::LookingAtVars;
-            } else if (x < 142 && y > 164) {
+            } else if (touched == &funcsButton) {
                 uiState = UIState::LookingAtFuncs;
-            } else if (x < 214 && y > 164) {
+            } else if (touched == &rpsButton) {
                 if (RPS.CurrentRegion() >= 0) {
                     uiState = UIState::UsingRPSConnected;
                 } else {
                     uiState = UIState::UsingRPSNotConnected;
                 }
                 
+            } else if (touched == &statsButton) {
+                uiState = UIState::LookingAtReports;
+            } else if (touched == &presetsButton) {
+                // What is saved may have changed since the list was last drawn
+                presetList.invalidate();
+                uiState = UIState::LookingAtPresets;
             }
             break;
 
-        case LookingAtVars:
-            if (x < 30 && y < 30) {
+        case LookingAtPresets:
+            if (touched == &backButton) {
                 uiState = UIState::Menu;
-                break;
+            } else if (touched == &presetList && presetList.itemAt(y) >= 0) {
+                selectedPreset = presetList.itemAt(y);
+                int count = VarStore::entryCount(appName, selectedPreset);
+                if (count < 0) {
+                    presetStatusLabel.setText("Nothing saved");
+                } else {
+                    presetStatusLabel.setFormat("%i variables saved", count);
+                }
+                uiState = UIState::AccessingPreset;
             }
-            for (int i = 0; i < currentVars; i++) {
-                if (y > (float)(37 + 24*i) && y < (float)(61 + 24*i)) {
-                    selectedVar = i;
-                    uiState = UIState::AccessingVar;
+            break;
+
+        case AccessingPreset:
+            if (touched == &backButton) {
+                presetList.invalidate();
+                uiState = UIState::LookingAtPresets;
+            } else if (touched == &saveButton) {
+                if (VarStore::save(appName, selectedPreset, variables, currentVars)) {
+                    presetStatusLabel.setFormat("Saved %i variables", currentVars);
+                } else {
+                    presetStatusLabel.setText("Could not write SD");
+                }
+            } else if (touched == &loadButton) {
+                int loaded = VarStore::load(appName, selectedPreset, variables, currentVars);
+                if (loaded < 0) {
+                    presetStatusLabel.setText("Nothing to load");
+                } else {
+                    // Keep what was loaded after a reset too
+                    if (selectedPreset != VARSTORE_BOOT_PRESET) saveBootPreset();
+                    presetStatusLabel.setFormat("Loaded %i of %i", loaded, currentVars);
                 }
             }
             break;
 
-        case LookingAtFuncs:
-            if (x < 30 && y < 30) {
+        case LookingAtReports:
+            if (touched == &backButton) {
                 uiState = UIState::Menu;
-                break;
+            } else if (touched == &reportList && reportList.itemAt(y) >= 0) {
+                selectedReport = reportList.itemAt(y);
+                reportCanvas.setDrawFunction(reportDrawFuncs[selectedReport]);
+                uiState = UIState::ViewingReport;
             }
-            for (int i = 0; i < currentFuncs; i++) {
-                if (y > (float)(37 + 24*i) && y < (float)(61 + 24*i)) {
-                    selectedFunc = i;
-                    uiState = UIState::AccessingFunc;
-                }
+            break;
+
+        case ViewingReport:
+            if (touched == &backButton) {
+                uiState = UIState::LookingAtReports;
+            } else {
+                // Touching anywhere else redraws the report with fresh numbers
+                reportCanvas.invalidate();
+            }
+            break;
+
+        case LookingAtVars:
+            if (touched == &backButton) {
+                uiState = UIState::Menu;
+            } else if (touched == &varList && varList.itemAt(y) >= 0) {
+                selectedVar = varList.itemAt(y);
+                saveStatusLabel.setText("");
+                uiState = UIState::AccessingVar;
+            }
+            break;
+
+        case LookingAtFuncs:
+            if (touched == &backButton) {
+                uiState = UIState::Menu;
+            } else if (touched == &funcList && funcList.itemAt(y) >= 0) {
+                selectedFunc = funcList.itemAt(y);
+                uiState = UIState::AccessingFunc;
             }
             break;
 
         case AccessingVar:
-            if (x < 30 && y < 30) {
+            if (touched == &backButton) {
                 uiState = UIState::LookingAtVars;
-                break;
-            }
-            if (x > 120 && x < 200 && y > 200) {
+            } else if (touched == &editButton) {
                 editVariable();
             }
             break;
 
         case AccessingFunc:
-            if (x < 30 && y < 30) {
+            if (touched == &backButton) {
                 uiState = UIState::LookingAtFuncs;
-                break;
-            }
-            if (y > 140 && x > 80 && x < 240) {
-                Debugger::debugFunction(funcNames[selectedFunc], funcPtrs[selectedFunc]);
+            } else if (touched == &debugButton) {
+                Debugger::debugFunction(functions[selectedFunc].name, functions[selectedFunc].ptr);
+                // The debugger used the whole screen
+                screen.redrawAll();
             }
             break;
 
         case UsingRPSNotConnected:
-            if (x < 30 && y < 30) {
+            if (touched == &backButton) {
                 uiState = UIState::Menu;
-                break;
-            }
-            if (y > 140 && x > 80 && x < 240) {
+            } else if (touched == &connectButton) {
                 RPS.InitializeTouchMenu();
                 uiState = UIState::UsingRPSConnected;
+                // So did the RPS menu
+                screen.redrawAll();
             }
             break;
 
         case UsingRPSConnected:
-            if (x < 30 && y < 30) {
+            if (touched == &backButton) {
                 uiState = UIState::Menu;
-                break;
             }
             break;
 
     }
 }
 
+void ProteOS::refreshUntilPressAndRelease(float* x, float* y) {
+    float xRead, yRead;
+    double nextRefresh = TimeNow();
+    while (!LCD.Touch(&xRead, &yRead)) {
+        if (TimeNow() >= nextRefresh) {
+            // Only the fields whose text changed are redrawn
+            drawScreen();
+            nextRefresh += DASHBOARD_PERIOD;
+            // Don't try to catch up after a slow redraw
+            if (nextRefresh < TimeNow()) nextRefresh = TimeNow() + DASHBOARD_PERIOD;
+        }
+    }
+
+    *x = -1;
+    *y = -1;
+    while (LCD.Touch(&xRead, &yRead)) {
+        if (xRead >= 0 && yRead >= 0) {
+            *x = xRead;
+            *y = yRead;
+        }
+    }
+}
+
+List* ProteOS::currentList() {
+    switch (uiState) {
+        case UIState::LookingAtVars:
+            return &varList;
+        case UIState::LookingAtFuncs:
+            return &funcList;
+        case UIState::LookingAtReports:
+            return &reportList;
+        case UIState::LookingAtPresets:
+            return &presetList;
+        default:
+            return NULL;
+    }
+}
+
+void ProteOS::setKeypadVisible(bool visible) {
+    for (unsigned int i = 0; i < sizeof(digitKeys) / sizeof(digitKeys[0]); i++) {
+        digitKeys[i].setVisible(visible);
+    }
+    deleteKey.setVisible(visible);
+    leftKey.setVisible(visible);
+    rightKey.setVisible(visible);
+    enterKey.setVisible(visible);
+}
+
 
 void ProteOS::editVariable() {
-    char text[BUFFER_SIZE + 1];
-    switch (varTypes[selectedVar]) {
-        case Bool:
-            snprintf(text, BUFFER_SIZE, "%i", *((char*) varPtrs[selectedVar]));
+    const ProteOSVariable& var = variables[selectedVar];
+    char* text = editField.text;
+    switch (var.type) {
+        case ProteOSVariable::Bool:
+            Format::print(text, BUFFER_SIZE, "%i", *((char*) var.ptr));
             break;
-        case Int:
-            snprintf(text, BUFFER_SIZE, "%i", *((int*) varPtrs[selectedVar]));
+        case ProteOSVariable::Int:
+            Format::print(text, BUFFER_SIZE, "%i", *((int*) var.ptr));
             break;
-        case Float:
-            snprintf(text, BUFFER_SIZE, "%.3f", *((float*) varPtrs[selectedVar]));
+        case ProteOSVariable::Float:
+            Format::print(text, BUFFER_SIZE, "%.3f", *((float*) var.ptr));
     }
-    size_t cursorPos = strlen(text);
-
-    // draw buttons
-    LCD.SetFontColor(backgroundColor);
-    LCD.FillRectangle(120, 200, 80, 40);
-    LCD.SetFontColor(foregroundColor);
-    LCD.WriteAt("7 8 9   <x  ", 88, 132);
-    LCD.WriteAt("4 5 6       ", 88, 156);
-    LCD.WriteAt("1 2 3  <   >", 88, 180);
-    LCD.WriteAt("- 0 .  Enter", 88, 204);
+    size_t& cursorPos = editField.cursorPos;
+    cursorPos = strlen(text);
 
+    // swap the Edit button for the keypad
+    editButton.setVisible(false);
+    saveStatusLabel.setText("");
+    editField.setVisible(true);
+    setKeypadVisible(true);
 
-
-    while (true) {
-        LCD.SetFontColor(backgroundColor);
-        LCD.FillRectangle(0, 96, 320, 20);
-        LCD.SetFontColor(foregroundColor);
-        LCD.WriteAt(text, 4, 96);
-        LCD.WriteAt("_", 4 + 12*cursorPos, 100);
+    bool editing = true;
+    bool changed = false;
+    while (editing) {
+        editField.invalidate();
+        screen.paint();
 
         // wait for input
         float x, y;
         Debugger::waitUntilPressAndRelease(&x, &y);
+        Widget* touched = screen.hit(x, y);
+        parseErrorLabel.setVisible(false);
 
         // process input
-        if (x > 82 && x < 154 && y > 129 && y < 225) {
-            // Numbers/Symbols
-            memmove(text+cursorPos+1, text+cursorPos, strlen(text+cursorPos) + 1);
-            int bx = (int)((x - 82) / 24);
-            int by = (int)((y - 129) / 24);
-            if (by == 3) {
-                text[cursorPos] = (bx == 0 ? '-' : (bx == 1 ? '0' : '.'));
-            } else {
-                text[cursorPos] = (char)('1' + 3*(2-by) + bx);
+        for (unsigned int i = 0; i < sizeof(digitKeys) / sizeof(digitKeys[0]); i++) {
+            if (touched == &digitKeys[i]) {
+                // Numbers/Symbols
+                memmove(text+cursorPos+1, text+cursorPos, strlen(text+cursorPos) + 1);
+                text[cursorPos] = digitKeyChars[i];
+                if (cursorPos < BUFFER_SIZE-1) cursorPos++;
             }
-            if (cursorPos < BUFFER_SIZE-1) cursorPos++;
-        } else if (x > 166 && x < 190 && y > 177 && y < 201) {
-            // <
+        }
+        if (touched == &leftKey) {
             if (cursorPos > 0) cursorPos--;
-        } else if (x > 214 && x < 238 && y > 177 && y < 201) {
-            // >
+        } else if (touched == &rightKey) {
             if (cursorPos < BUFFER_SIZE-1 && cursorPos < strlen(text)) cursorPos++;
-        } else if (x > 178 && x < 214 && y > 129 && y < 153) {
-            // <x
+        } else if (touched == &deleteKey) {
             if (cursorPos > 0) {
                 cursorPos--;
                 memmove(text+cursorPos, text+cursorPos+1, strlen(text+cursorPos+1) + 1);
             }
-        } else if (x > 166 && x < 238 && y > 201 && y < 225) {
-            // Enter
+        } else if (touched == &enterKey) {
             int outputI;
             float outputF;
-            int success;
-            switch (varTypes[selectedVar]) {
-                case Bool:
-                    outputI = 0;
-                    success = sscanf(text, "%i", &outputI);
-                    if (success) {
-                        *((bool*) varPtrs[selectedVar]) = (bool) outputI;
-                        return;
-                    }
+            bool success = false;
+            switch (var.type) {
+                case ProteOSVariable::Bool:
+                    success = Format::parseInt(text, &outputI);
+                    if (success) *((bool*) var.ptr) = (bool) outputI;
                     break;
-                case Int:
-                    outputI = 0;
-                    success = sscanf(text, "%i", &outputI);
-                    if (success) {
-                        *((int*) varPtrs[selectedVar]) = outputI;
-                        return;
-                    }
+                case ProteOSVariable::Int:
+                    success = Format::parseInt(text, &outputI);
+                    if (success) *((int*) var.ptr) = outputI;
                     break;
-                case Float:
-                    outputF = 0;
-                    success = sscanf(text, "%f", &outputF);
-                    if (success) {
-                        *((float*) varPtrs[selectedVar]) = outputF;
-                        return;
-                    } else {
-                        LCD.WriteAt("Parse error", 160, 80);
-                        while (!LCD.Touch(&x, &y));
-                        LCD.SetFontColor(backgroundColor);
-                        LCD.WriteAt("Parse error", 160, 80);
-                        LCD.SetFontColor(foregroundColor);
-                    }
+                case ProteOSVariable::Float:
+                    success = Format::parseFloat(text, &outputF);
+                    if (success) *((float*) var.ptr) = outputF;
                     break;
             }
-            
-        } else if (x < 30 && y < 30) {
-            return;
+            if (success) {
+                editing = false;
+                changed = true;
+            } else {
+                parseErrorLabel.setVisible(true);
+            }
+        } else if (touched == &backButton) {
+            editing = false;
         }
     }
+
+    setKeypadVisible(false);
+    editField.setVisible(false);
+    parseErrorLabel.setVisible(false);
+    editButton.setVisible(true);
+
+    if (changed) {
+        saveStatusLabel.setText(saveBootPreset() ? "Saved" : "Not saved");
+    }
 }
 
 
@@ -4,8 +4,49 @@
 #include "debugger.hpp"
 
 
-#define MAX_VARIABLES 8
-#define MAX_FUNCTIONS 8
+#define MAX_REPORTS 8
+
+// Rows in each page of the variable, function, and report lists
+#define LIST_PAGE_ROWS 7
+
+// How often the RPS page refreshes its readings while it is open, in seconds
+#define DASHBOARD_PERIOD 0.1
+
+
+class List;
+
+
+// A variable that can be read and changed from the menu. Apps list their variables in a
+//   static constexpr array, which is placed in flash, and pass it to ProteOS::setVariables():
+//
+//   static constexpr ProteOSVariable variables[] = {
+//       { "motorPower", &Motors::maxPower },
+//       { "doWillThing", &doWillThing },
+//   };
+//
+// Currently supported variable types: int, float, and bool
+struct ProteOSVariable {
+    enum Type {
+        Bool,
+        Int,
+        Float
+    };
+
+    const char* name;
+    Type type;
+    void* ptr;
+
+    constexpr ProteOSVariable(const char* name_, int* ptr_) : name(name_), type(Int), ptr(ptr_) {}
+    constexpr ProteOSVariable(const char* name_, float* ptr_) : name(name_), type(Float), ptr(ptr_) {}
+    constexpr ProteOSVariable(const char* name_, bool* ptr_) : name(name_), type(Bool), ptr(ptr_) {}
+};
+
+// A function that can be called from the menu. Listed the same way as ProteOSVariable, and
+//   passed to ProteOS::setFunctions(). Function must have no arguments and return nothing.
+struct ProteOSFunction {
+    const char* name;
+    void (*ptr)();
+};
 
 
 class ProteOS {
@@ -17,17 +58,30 @@ public:
     static int foregroundColor;
 
 
-    // Registers a variable so that it can be read and changed from the menu.
-    // Currently supported variable types: int, float, and bool
-    static void registerVariable(const char* variableName, int* varPtr);
-    static void registerVariable(const char* variableName, float* varPtr);
-    static void registerVariable(const char* variableName, bool* varPtr);
+    // Sets the variables that can be read and changed from the menu. Only the array's address
+    //   is kept, so it must outlive the menu; there is no limit on how many it holds.
+    template <int N>
+    static void setVariables(const ProteOSVariable (&vars)[N]) { setVariables(vars, N); }
+    static void setVariables(const ProteOSVariable* vars, int count);
+
+    // Names the app, which keys its saved presets on the SD card (see varstore.hpp). Apps with
+    //   variables must call this before run(); use the app's directory name.
+    static void setAppName(const char* name);
+
+    // Sets the functions that can be called from the menu, like setVariables().
+    template <int N>
+    static void setFunctions(const ProteOSFunction (&funcs)[N]) { setFunctions(funcs, N); }
+    static void setFunctions(const ProteOSFunction* funcs, int count);
 
-    // Registers a function so that it can be called from the menu. Function must have no 
-    //   arguments and return nothing.
-    static void registerFunction(const char* functionName, void (*funcPtr)());
+    // Registers a report page that can be opened from the Stats menu, e.g.
+    //   LoopMonitor::drawReport. The draw function should draw below the title bar (y >= 40)
+    //   in the current font color, and is called again each time the page is touched. Fails an
+    //   assertion, or returns false when assertions are compiled out, if there are already
+    //   MAX_REPORTS.
+    static bool registerReport(const char* reportName, void (*drawFunc)());
 
-    // Opens the menu to allow the user to access variables and functions.
+    // Opens the menu to allow the user to access variables and functions. Variables saved in
+    //   the boot preset (see varstore.hpp) are loaded first, and every edit is saved to it.
     static void run();
 
 
@@ -40,33 +94,51 @@ private:
         AccessingVar,
         AccessingFunc,
         UsingRPSNotConnected,
-        UsingRPSConnected
+        UsingRPSConnected,
+        LookingAtReports,
+        ViewingReport,
+        LookingAtPresets,
+        AccessingPreset
     };
     static UIState uiState;
 
-    enum VariableType {
-        Bool,
-        Int,
-        Float
-    };
-
-    static const char* varNames[MAX_VARIABLES];
-    static VariableType varTypes[MAX_VARIABLES];
-    static void* varPtrs[MAX_VARIABLES];
+    static const char* appName;
+    static const ProteOSVariable* variables;
+    static const ProteOSFunction* functions;
 
-    static const char* funcNames[MAX_FUNCTIONS];
-    static void (*funcPtrs[MAX_FUNCTIONS])();
+    static const char* reportNames[MAX_REPORTS];
+    static void (*reportDrawFuncs[MAX_REPORTS])();
 
     static int currentVars;
     static int currentFuncs;
+    static int currentReports;
 
     static int selectedVar;
     static int selectedFunc;
+    static int selectedReport;
+    static int selectedPreset;
 
 
+    static void setupWidgets();
+    // Shows the widgets for the current state and repaints the ones that changed
     static void drawScreen();
     static void waitForInput();
+    // Like Debugger::waitUntilPressAndRelease(), but redraws the screen every DASHBOARD_PERIOD
+    //   until the screen is pressed
+    static void refreshUntilPressAndRelease(float* x, float* y);
     static void editVariable();
+    static void setKeypadVisible(bool visible);
+    // The list shown in the current state, or NULL if there is none
+    static List* currentList();
+    static const char* variableName(int i);
+    static const char* functionName(int i);
+    static const char* reportName(int i);
+    static const char* presetName(int i);
+    static void formatPreset(int i, char* buf, int size);
+    // Saves the variables to the preset loaded at startup. Returns false if that failed.
+    static bool saveBootPreset();
+    static void formatVariable(int i, char* buf, int size);
+    static void formatSelectedVariable(char* buf, int size);
     static void drawFolderIcon(int x, int y);
     static void drawRPSIcon(int x, int y);
 };
@@ -1 +1 @@
-proteos_LIBS := debugger
\ No newline at end of file
+proteos_LIBS := assert batterymonitor debugger format navigation varstore widgets
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "sampler.hpp"
+
+#include "ticker.hpp"
+
+
+// Static variable definitions
+
+Sampler::Channel Sampler::channels[MAX_SAMPLER_CHANNELS];
+volatile int Sampler::channelCount = 0;
+
+SpscQueue<SamplerEvent, SAMPLER_EVENT_CAPACITY> Sampler::events;
+
+
+// Function definitions
+
+int Sampler::registerPin(AnalogInputPin* pin, int oversampling, int window) {
+    if (channelCount >= MAX_SAMPLER_CHANNELS) return -1;
+
+    if (oversampling < 1) oversampling = 1;
+    if (window < 1) window = 1;
+    if (window > SAMPLER_HISTORY) window = SAMPLER_HISTORY;
+
+    int channel = channelCount;
+    Channel& c = channels[channel];
+    c.pin = pin;
+    c.oversampling = oversampling;
+    c.window = window;
+    c.historyPos = 0;
+    c.thresholdsSet = false;
+
+    // Make the channel visible to the interrupt only once it is filled in
+    MEMORY_BARRIER();
+    channelCount = channel + 1;
+
+    if (channel == 0) {
+        Ticker::addTask(&sampleAll, SAMPLER_PERIOD_MS);
+    }
+    return channel;
+}
+
+void Sampler::setThresholds(int channel, float low, float high, int debounce) {
+    if (channel < 0 || channel >= channelCount) return;
+    Channel& c = channels[channel];
+    c.thresholdsSet = false;
+    MEMORY_BARRIER();
+    c.lowThreshold = low;
+    c.highThreshold = high;
+    c.debounce = debounce < 1 ? 1 : debounce;
+    c.pendingCount = 0;
+    // Start out on whichever side the channel currently is, so no event is sent just for
+    //   setting the thresholds
+    c.isHigh = value(channel) >= low;
+    MEMORY_BARRIER();
+    c.thresholdsSet = true;
+}
+
+float Sampler::value(int channel) {
+    SamplerStats s;
+    stats(channel, &s);
+    return s.latest;
+}
+
+float Sampler::average(int channel) {
+    SamplerStats s;
+    stats(channel, &s);
+    return s.average;
+}
+
+float Sampler::min(int channel) {
+    SamplerStats s;
+    stats(channel, &s);
+    return s.min;
+}
+
+float Sampler::max(int channel) {
+    SamplerStats s;
+    stats(channel, &s);
+    return s.max;
+}
+
+bool Sampler::stats(int channel, SamplerStats* out) {
+    if (channel < 0 || channel >= channelCount) {
+        *out = SamplerStats();
+        return false;
+    }
+    return channels[channel].latest.read(out);
+}
+
+bool Sampler::pollEvent(SamplerEvent* event) {
+    return events.pop(event);
+}
+
+void Sampler::clearEvents() {
+    SamplerEvent discarded;
+    while (events.pop(&discarded));
+}
+
+void Sampler::sampleAll() {
+    int count = channelCount;
+    for (int i = 0; i < count; i++) {
+        sample(i);
+    }
+}
+
+void Sampler::sample(int channel) {
+    Channel& c = channels[channel];
+
+    // Oversample
+    float sum = 0;
+    for (int i = 0; i < c.oversampling; i++) {
+        sum += c.pin->Value();
+    }
+    float reading = sum / (float) c.oversampling;
+
+    c.history[c.historyPos & (SAMPLER_HISTORY - 1)] = reading;
+    c.historyPos++;
+
+    // Moving average, min and max over the window (or however many readings there are)
+    int n = c.historyPos < (uint32_t) c.window ? (int) c.historyPos : c.window;
+    float windowSum = 0, windowMin = reading, windowMax = reading;
+    for (int i = 0; i < n; i++) {
+        float h = c.history[(c.historyPos - 1 - (uint32_t) i) & (SAMPLER_HISTORY - 1)];
+        windowSum += h;
+        if (h < windowMin) windowMin = h;
+        if (h > windowMax) windowMax = h;
+    }
+
+    SamplerStats s;
+    s.latest = reading;
+    s.average = windowSum / (float) n;
+    s.min = windowMin;
+    s.max = windowMax;
+    s.sampleCount = c.historyPos;
+    s.timeMs = Ticker::millis();
+    c.latest.write(s);
+
+    // Edge detection with hysteresis and debouncing
+    if (c.thresholdsSet) {
+        bool pastThreshold = c.isHigh ? reading < c.lowThreshold : reading > c.highThreshold;
+        if (!pastThreshold) {
+            c.pendingCount = 0;
+        } else {
+            if (c.pendingCount == 0) c.pendingTimeMs = s.timeMs;
+            c.pendingCount++;
+            if (c.pendingCount >= c.debounce) {
+                c.isHigh = !c.isHigh;
+                c.pendingCount = 0;
+
+                SamplerEvent event;
+                event.channel = channel;
+                event.rising = c.isHigh;
+                event.value = reading;
+                event.timeMs = c.pendingTimeMs;
+                events.push(event);
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+
+#include "FEHIO.h"
+
+#include "stdint.h"
+
+#include "spsc.hpp"
+
+
+#define MAX_SAMPLER_CHANNELS 4
+
+// How many filtered samples each channel keeps. Must be a power of two, and is the largest
+//   allowed moving average window.
+#define SAMPLER_HISTORY 32
+
+// Time between samples of each channel, in milliseconds
+#define SAMPLER_PERIOD_MS 2
+
+// How many edge events can be waiting before new ones are dropped
+#define SAMPLER_EVENT_CAPACITY 16
+
+
+// A snapshot of one channel, published by the sampling interrupt.
+struct SamplerStats {
+    // The most recent oversampled reading, in volts
+    float latest;
+    // The mean of the last `window` readings
+    float average;
+    // The smallest and largest of the last `window` readings
+    float min, max;
+    // How many readings have been taken since the channel was registered
+    uint32_t sampleCount;
+    // Ticker::millis() when the latest reading was taken
+    uint32_t timeMs;
+};
+
+// Sent when a channel's readings cross one of its thresholds.
+struct SamplerEvent {
+    int channel;
+    // True if the readings went above the high threshold, false if they went below the low one
+    bool rising;
+    // The reading that completed the debounce
+    float value;
+    // Ticker::millis() when the first reading past the threshold was taken, so debouncing
+    //   doesn't add to the reported time
+    uint32_t timeMs;
+};
+
+
+// Reads registered AnalogInputPins in the background at a fixed rate, so apps can get
+//   filtered values instantly instead of busy-polling the ADC.
+//
+// Once a pin is registered, it should only be read through the Sampler. Calling Value() on
+//   it (or any other analog pin) from the main loop can collide with a background read.
+class Sampler {
+public:
+
+    // Starts sampling a pin every SAMPLER_PERIOD_MS. Each reading averages `oversampling`
+    //   raw ADC conversions, and the average/min/max cover the last `window` readings.
+    //   Returns the channel number to use with the other functions, or -1 if there are
+    //   already MAX_SAMPLER_CHANNELS channels.
+    static int registerPin(AnalogInputPin* pin, int oversampling = 4, int window = 8);
+
+    // Sets the thresholds at which edge events are sent. A falling event is sent once
+    //   `debounce` readings in a row are below low, and the next rising event is only sent
+    //   once `debounce` readings in a row are above high (and vice versa), so high should be
+    //   at least low. Edges use the oversampled readings rather than the moving average,
+    //   so they are only delayed by the debounce.
+    static void setThresholds(int channel, float low, float high, int debounce = 1);
+
+    // Accessors for the latest snapshot of a channel. These are cheap and never touch the ADC.
+    static float value(int channel);
+    static float average(int channel);
+    static float min(int channel);
+    static float max(int channel);
+
+    // Copies the whole latest snapshot of a channel. Returns false if no reading has been
+    //   taken yet.
+    static bool stats(int channel, SamplerStats* out);
+
+    // Takes the oldest waiting edge event. Returns false if there are none.
+    static bool pollEvent(SamplerEvent* event);
+
+    // Throws away every waiting edge event.
+    static void clearEvents();
+
+
+private:
+
+    struct Channel {
+        AnalogInputPin* pin;
+        int oversampling;
+        int window;
+
+        float history[SAMPLER_HISTORY];
+        uint32_t historyPos;
+
+        bool thresholdsSet;
+        float lowThreshold, highThreshold;
+        int debounce;
+        // Which side of the thresholds the readings were last on
+        bool isHigh;
+        // How many readings in a row have been on the other side, and when the first was
+        int pendingCount;
+        uint32_t pendingTimeMs;
+
+        LatestValue<SamplerStats> latest;
+    };
+
+    static Channel channels[MAX_SAMPLER_CHANNELS];
+    static volatile int channelCount;
+
+    static SpscQueue<SamplerEvent, SAMPLER_EVENT_CAPACITY> events;
+
+    static void sampleAll();
+    static void sample(int channel);
+};
+
+#endif
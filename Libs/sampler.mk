@@ -0,0 +1 @@
+sampler_LIBS := ticker
\ No newline at end of file
@@ -0,0 +1,143 @@
+#ifndef SPSC_HPP
+#define SPSC_HPP
+
+#include "stdint.h"
+
+#include <type_traits>
+
+
+// Orders every memory access before it against every memory access after it. On the
+//   Cortex-M4 this is a DMB instruction (1-3 cycles), and the "memory" clobber also stops
+//   the compiler from caching shared data in registers across it. The host build falls
+//   back to a full fence so these headers can be used by host-side tools.
+#ifdef __arm__
+#define MEMORY_BARRIER() __asm volatile ("dmb" ::: "memory")
+#else
+#define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+
+// A fixed-capacity, allocation-free ring buffer for handing items from exactly one
+//   producer to exactly one consumer, e.g. from an interrupt handler to the main loop.
+//   Neither side ever blocks or disables interrupts.
+//
+// Capacity must be a power of two. The head and tail indices are free-running 32-bit
+//   counters, so the ring can hold all Capacity items without a wasted slot.
+//
+// Cost: push() and pop() are two index loads, one copy of T, two DMBs and one index store.
+//   The Bench app times a push() and pop() pair on the robot ("SPSC push+pop"), and
+//   Tools/spsctest stress-tests the queue with two threads on the host.
+template <typename T, uint32_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscQueue items are copied with plain assignment");
+
+public:
+
+    // Producer side. Copies the item into the queue, and returns false if the queue was
+    //   full, in which case the item is dropped.
+    bool push(const T& item) {
+        uint32_t h = head;
+        uint32_t t = tail;
+        if (h - t >= Capacity) return false;
+        // The consumer must be done reading this slot before we overwrite it
+        MEMORY_BARRIER();
+        buffer[h & (Capacity - 1)] = item;
+        // The item must be written before the new head makes it visible
+        MEMORY_BARRIER();
+        head = h + 1;
+        return true;
+    }
+
+    // Consumer side. Copies the oldest item into *item and removes it from the queue. Returns
+    //   false if the queue was empty, in which case *item is left unchanged.
+    bool pop(T* item) {
+        uint32_t t = tail;
+        if (head == t) return false;
+        // Don't read the slot until we have seen the head that published it
+        MEMORY_BARRIER();
+        *item = buffer[t & (Capacity - 1)];
+        // Finish reading the slot before handing it back to the producer
+        MEMORY_BARRIER();
+        tail = t + 1;
+        return true;
+    }
+
+    // Either side. Returns how many items are waiting. The value may be stale by the time
+    //   it is used, but it is never larger than the capacity.
+    uint32_t size() const {
+        return head - tail;
+    }
+
+    bool empty() const {
+        return head == tail;
+    }
+
+    static constexpr uint32_t capacity() {
+        return Capacity;
+    }
+
+private:
+    T buffer[Capacity];
+    // Only written by the producer
+    volatile uint32_t head = 0;
+    // Only written by the consumer
+    volatile uint32_t tail = 0;
+};
+
+
+// A double-buffered cell holding the most recent value of something that is updated by one
+//   writer and read by anyone, e.g. a pose or sensor snapshot written from an interrupt.
+//   Readers always get a complete value from a single write, never a mix of two.
+//
+// The writer fills whichever buffer is not currently published, then bumps a sequence
+//   number to publish it. A reader retries if the sequence changed while it was copying,
+//   which can only happen when the writer interrupts the reader, so the retry loop always
+//   finishes.
+//
+// Cost: write() is one copy of T and one DMB. read() is one copy of T and two DMBs when it
+//   doesn't have to retry. Bench times a write() and read() pair of a pose ("Latest wr+rd"),
+//   and Tools/spsctest stress-tests the cell with two threads.
+template <typename T>
+class LatestValue {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "LatestValue items are copied with plain assignment");
+
+public:
+
+    // Writer side. Publishes a new value.
+    void write(const T& value) {
+        uint32_t s = sequence;
+        buffers[(s + 1) & 1] = value;
+        // The value must be written before the new sequence number publishes it
+        MEMORY_BARRIER();
+        sequence = s + 1;
+    }
+
+    // Reader side. Copies the latest value into *value, and returns false if nothing has
+    //   been written yet (in which case *value is a default-constructed T).
+    bool read(T* value) const {
+        uint32_t s;
+        do {
+            s = sequence;
+            MEMORY_BARRIER();
+            *value = buffers[s & 1];
+            MEMORY_BARRIER();
+        } while (sequence != s);
+        return s != 0;
+    }
+
+    // Returns how many times the value has been written. Readers can compare this against
+    //   a previous count to tell whether anything new has arrived.
+    uint32_t writeCount() const {
+        return sequence;
+    }
+
+private:
+    T buffers[2] = {};
+    volatile uint32_t sequence = 0;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "startlight.hpp"
+
+#include "debugger.hpp"
+#include "format.hpp"
+#include "navigation.hpp"
+#include "sampler.hpp"
+#include "ticker.hpp"
+
+#include "stddef.h"
+
+#include "FEHLCD.h"
+#include "FEHSD.h"
+#include "FEHUtility.h"
+
+
+// Static variable definitions
+
+float StartLight::darkLevel = 3.0f;
+float StartLight::litLevel = 0.5f;
+
+int StartLight::channel = -1;
+bool StartLight::darkCalibrated = false;
+bool StartLight::litCalibrated = false;
+uint32_t StartLight::lightOnMs = 0;
+int StartLight::reactionTimeMs = -1;
+bool StartLight::reactionLogged = true;
+
+
+// Function definitions
+
+void StartLight::setup(int samplerChannel) {
+    channel = samplerChannel;
+    Debugger::addFinishHandler(&logReactionTime);
+}
+
+float StartLight::measureLevel() {
+    // Average the sampler's moving average over the calibration time
+    float sum = 0;
+    int count = 0;
+    double endTime = TimeNow() + START_LIGHT_CALIBRATION_TIME;
+    while (TimeNow() < endTime) {
+        sum += Sampler::average(channel);
+        count++;
+        Debugger::sleep(0.01f);
+    }
+    return count > 0 ? sum / (float) count : Sampler::average(channel);
+}
+
+// Measures the dark or lit level and returns it. Measures again until it is far enough from the
+//   other level, if that level can be trusted.
+float StartLight::calibrateLevel(bool lit) {
+    const char* name = lit ? "Lit" : "Dark";
+    const char* otherName = lit ? "dark" : "lit";
+    bool otherCalibrated = lit ? darkCalibrated : litCalibrated;
+    while (true) {
+        float level = measureLevel();
+        Debugger::printNextLine("%s level: %.3f V", name, level);
+
+        // The CdS cell reads lower when lit
+        float contrast = lit ? darkLevel - level : level - litLevel;
+        if (contrast >= START_LIGHT_MIN_CONTRAST) return level;
+
+        Debugger::setFontColor(Debugger::errorColor);
+        if (contrast <= 0) {
+            Debugger::printNextLine(lit ? "Not below dark level!" : "Not above lit level!");
+        } else {
+            Debugger::printNextLine("Only %.3f V from %s", contrast, otherName);
+        }
+        Debugger::setFontColor();
+
+        // A loaded or edited level can't be checked against, so don't hold this one to it
+        if (!otherCalibrated) {
+            Debugger::printNextLine("Kept. Now calibrate %s.", otherName);
+            return level;
+        }
+        Debugger::printNextLine("Fix the light to retry.");
+        Debugger::breakpoint();
+        Debugger::clear();
+    }
+}
+
+void StartLight::calibrateDark() {
+    darkLevel = calibrateLevel(false);
+    darkCalibrated = true;
+}
+
+void StartLight::calibrateLit() {
+    litLevel = calibrateLevel(true);
+    litCalibrated = true;
+}
+
+bool StartLight::wait(float timeout) {
+    float range = darkLevel - litLevel;
+    float triggerLevel = darkLevel - START_LIGHT_TRIGGER_FRACTION * range;
+    float releaseLevel = darkLevel - START_LIGHT_RELEASE_FRACTION * range;
+
+    Sampler::setThresholds(channel, triggerLevel, releaseLevel, START_LIGHT_DEBOUNCE);
+    Sampler::clearEvents();
+
+    reactionTimeMs = -1;
+    reactionLogged = true;
+
+    // If the light is already on, there won't be an edge to wait for
+    bool seen = Sampler::value(channel) < triggerLevel;
+    lightOnMs = Ticker::millis();
+
+    double endTime = TimeNow() + timeout;
+    SamplerEvent event;
+    while (!seen) {
+        if (Sampler::pollEvent(&event)) {
+            if (event.channel == channel && !event.rising) {
+                lightOnMs = event.timeMs;
+                seen = true;
+            }
+            continue;
+        }
+        Debugger::abortCheck();
+        if (TimeNow() > endTime) return false;
+    }
+
+    // Time the first motor command from here on
+    reactionLogged = false;
+    Motors::onMotorCommand = &onMotorCommand;
+    return true;
+}
+
+void StartLight::onMotorCommand() {
+    // Only the first command counts, and this runs in the middle of a movement, so just
+    //   record the time and leave the printing for later
+    reactionTimeMs = (int) (Ticker::millis() - lightOnMs);
+    Motors::onMotorCommand = NULL;
+}
+
+int StartLight::getReactionTimeMs() {
+    return reactionTimeMs;
+}
+
+void StartLight::logReactionTime() {
+    if (reactionLogged) return;
+    reactionLogged = true;
+    Motors::onMotorCommand = NULL;
+
+    if (reactionTimeMs < 0) {
+        Debugger::printNextLine("No motor cmd after light");
+        return;
+    }
+    Debugger::printNextLine("Reaction time: %i ms", reactionTimeMs);
+
+    FEHFile* file = SD.FOpen(START_LIGHT_LOG_FILE, "a");
+    if (file == NULL) return;
+    SD.FPrintf(file, "%i\n", reactionTimeMs);
+    SD.FClose(file);
+}
+
+void StartLight::drawReport() {
+    char buf[BUFFER_SIZE + 1];
+
+    Format::print(buf, BUFFER_SIZE, "Dark: %.3f V", darkLevel);
+    LCD.WriteAt(buf, 16, 40);
+    Format::print(buf, BUFFER_SIZE, "Lit:  %.3f V", litLevel);
+    LCD.WriteAt(buf, 16, 64);
+    Format::print(buf, BUFFER_SIZE, "Now:  %.3f V", Sampler::average(channel));
+    LCD.WriteAt(buf, 16, 88);
+
+    if (reactionTimeMs >= 0) {
+        Format::print(buf, BUFFER_SIZE, "Reaction: %i ms", reactionTimeMs);
+    } else {
+        Format::print(buf, BUFFER_SIZE, "Reaction: none yet");
+    }
+    LCD.WriteAt(buf, 16, 136);
+}
@@ -0,0 +1,85 @@
+#ifndef STARTLIGHT_HPP
+#define STARTLIGHT_HPP
+
+#include "stdint.h"
+
+
+// How many readings in a row (SAMPLER_PERIOD_MS apart) must see the light before the start
+//   counts. Rejects single noisy samples at the cost of a few milliseconds.
+#define START_LIGHT_DEBOUNCE 3
+
+// Where between the dark and lit levels the trigger and release thresholds sit. The gap
+//   between them is the hysteresis.
+#define START_LIGHT_TRIGGER_FRACTION 0.6f
+#define START_LIGHT_RELEASE_FRACTION 0.4f
+
+// How long each calibration averages over, in seconds
+#define START_LIGHT_CALIBRATION_TIME 0.25f
+
+// How far below the dark level, in volts, the lit level must read for a calibration to be
+//   kept. Closer levels would leave the thresholds within the sensor's noise.
+#define START_LIGHT_MIN_CONTRAST 0.3f
+
+// File on the SD card that reaction times are appended to
+#define START_LIGHT_LOG_FILE "STARTLAT.TXT"
+
+
+// Detects the start light with calibrated thresholds, hysteresis and debouncing, and
+//   measures how long the robot takes to send its first motor command after the light
+//   turns on.
+//
+// The CdS cell reads lower when lit. Until calibrated, the levels default to 3.0 V (dark)
+//   and 0.5 V (lit), which puts the trigger at about 1 V like the old hand-picked threshold.
+class StartLight {
+public:
+
+    // Voltage levels with the start light off and on. Set by the calibrate functions, and
+    //   public so they can be registered as ProteOS variables.
+    static float darkLevel;
+    static float litLevel;
+
+    // Uses a light sensor that is already registered with the Sampler. Also hooks the
+    //   reaction time logging into the debugger.
+    static void setup(int samplerChannel);
+
+    // Record the current reading as the dark or lit level. Meant to be registered as ProteOS
+    //   functions and run with the robot sitting on the start light. The reading should be at
+    //   least START_LIGHT_MIN_CONTRAST from the other level, on the right side of it. If the
+    //   other level was calibrated since boot and the reading isn't, the user is prompted to
+    //   fix the lighting and it is measured again, until the run is aborted. If the other
+    //   level was only loaded or edited, it may be the stale one, so the reading is kept and
+    //   the user is told to recalibrate the other level. Must be run in the debugger.
+    static void calibrateDark();
+    static void calibrateLit();
+
+    // Waits until the start light turns on, or until timeout seconds pass. Returns true if
+    //   the light was seen. Can be aborted from the debugger.
+    static bool wait(float timeout);
+
+    // Milliseconds from the light turning on to the first motor command of the last start,
+    //   or -1 if that hasn't been measured.
+    static int getReactionTimeMs();
+
+    // Prints the reaction time of the last start and appends it to START_LIGHT_LOG_FILE.
+    //   Called automatically when a debugger run finishes.
+    static void logReactionTime();
+
+    // Draws the calibration and last reaction time, for use with ProteOS::registerReport().
+    static void drawReport();
+
+
+private:
+    static int channel;
+    // Whether each level has been measured since boot, rather than loaded or left at its default
+    static bool darkCalibrated;
+    static bool litCalibrated;
+    static uint32_t lightOnMs;
+    static int reactionTimeMs;
+    static bool reactionLogged;
+
+    static float measureLevel();
+    static float calibrateLevel(bool lit);
+    static void onMotorCommand();
+};
+
+#endif
@@ -0,0 +1 @@
+startlight_LIBS := debugger format navigation sampler ticker
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "telemetry.hpp"
+
+#include "debugger.hpp"
+#include "loopmonitor.hpp"
+
+#include "stddef.h"
+
+#include "FEHSD.h"
+
+
+// Static variable definitions
+
+TelemetryRecord Telemetry::records[TELEMETRY_CAPACITY];
+uint32_t Telemetry::head = 0;
+bool Telemetry::enabled = false;
+void (*Telemetry::onRecord)(const TelemetryRecord& r) = NULL;
+void (*Telemetry::onFlush)(FEHFile* file) = NULL;
+
+
+// Function definitions
+
+void Telemetry::enable() {
+    if (enabled) return;
+    enabled = true;
+    Debugger::addStartHandler(&clear);
+    Debugger::addFinishHandler(&flushIfRecorded);
+}
+
+bool Telemetry::isEnabled() {
+    return enabled;
+}
+
+void Telemetry::record(const TelemetryRecord& r) {
+    if (onRecord != NULL) (*onRecord)(r);
+    if (!enabled) return;
+    if (head > 0) {
+        const TelemetryRecord& last = records[(head - 1) & (TELEMETRY_CAPACITY - 1)];
+        bool powerChanged = r.leftPower != last.leftPower || r.rightPower != last.rightPower;
+        if (!powerChanged && r.timeMs - last.timeMs < TELEMETRY_PERIOD_MS) return;
+    }
+    records[head & (TELEMETRY_CAPACITY - 1)] = r;
+    head++;
+}
+
+void Telemetry::clear() {
+    head = 0;
+}
+
+int Telemetry::count() {
+    return head < TELEMETRY_CAPACITY ? (int) head : TELEMETRY_CAPACITY;
+}
+
+bool Telemetry::get(int i, TelemetryRecord* out) {
+    if (i < 0 || i >= count()) return false;
+    uint32_t oldest = head - (uint32_t) count();
+    *out = records[(oldest + (uint32_t) i) & (TELEMETRY_CAPACITY - 1)];
+    return true;
+}
+
+bool Telemetry::flush() {
+    FEHFile* file = SD.FOpen(TELEMETRY_FILE, "w");
+    if (file == NULL) return false;
+
+    // FEHSD can only write text, so each record goes on its own line as hex, in the byte
+    //   order it has in RAM (little-endian). The header says how to decode the lines.
+    int n = count();
+    SD.FPrintf(file, "TLM %i %i %i %i\n", TELEMETRY_VERSION, (int) sizeof(TelemetryRecord), n,
+               LoopMonitor::count());
+
+    for (int i = 0; i < LoopMonitor::count(); i++) {
+        const LoopMonitor* m = LoopMonitor::get(i);
+        SD.FPrintf(file, "LOOP %s %lu %lu %lu %lu %lu %lu\n", m->getName(),
+                   (unsigned long) m->getIterations(), (unsigned long) m->getOverruns(),
+                   (unsigned long) m->getRateHz(), (unsigned long) m->getIntervalPercentileUs(0.5f),
+                   (unsigned long) m->getIntervalPercentileUs(0.9f),
+                   (unsigned long) m->getIntervalPercentileUs(0.99f));
+    }
+    if (onFlush != NULL) (*onFlush)(file);
+
+    static const char digits[] = "0123456789ABCDEF";
+    char line[2*sizeof(TelemetryRecord) + 1];
+    TelemetryRecord r;
+    for (int i = 0; i < n; i++) {
+        get(i, &r);
+        const uint8_t* bytes = (const uint8_t*) &r;
+        for (unsigned int b = 0; b < sizeof(TelemetryRecord); b++) {
+            line[2*b] = digits[bytes[b] >> 4];
+            line[2*b + 1] = digits[bytes[b] & 0xF];
+        }
+        line[2*sizeof(TelemetryRecord)] = '\0';
+        SD.FPrintf(file, "%s\n", line);
+    }
+
+    SD.FClose(file);
+    return true;
+}
+
+void Telemetry::flushIfRecorded() {
+    // Don't overwrite the last useful log with an empty one
+    if (head == 0) return;
+    if (!flush()) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printNextLine("Telemetry not saved");
+        Debugger::setFontColor();
+    }
+}
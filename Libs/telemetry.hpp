@@ -0,0 +1,104 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include "stdint.h"
+
+// From FEHSD.h, which isn't included so that host-side tools can use this header
+struct FEHFile;
+
+
+// How many records the RAM ring holds (must be a power of two). At 40 bytes each this is
+//   20 KB.
+#define TELEMETRY_CAPACITY 512
+
+// Least time between two records kept in the ring, in milliseconds. The movement loop offers
+//   one every millisecond or so; keeping one in 10 means the ring covers the last
+//   TELEMETRY_CAPACITY * TELEMETRY_PERIOD_MS = 5.1 seconds of driving, a little less when
+//   the power changes often (see record()).
+#define TELEMETRY_PERIOD_MS 10
+
+// File on the SD card the ring is written to after each debugger run
+#define TELEMETRY_FILE "TLM.TXT"
+
+// Bump when TelemetryRecord changes, so old logs aren't decoded with the new layout
+#define TELEMETRY_VERSION 4
+
+
+// One sample of the robot's state. Fixed size so the ring is a plain array.
+struct TelemetryRecord {
+    // Ticker::millis()
+    uint32_t timeMs;
+    // Encoder counts since the current movement started
+    int32_t leftCounts, rightCounts;
+    // Commanded motor power, in hundredths of a percent
+    int16_t leftPower, rightPower;
+    // Pose from odometry, in inches and degrees
+    float x, y, heading;
+    // The most recent RPS readings, which may be error codes (negative)
+    float rpsX, rpsY, rpsHeading;
+};
+
+static_assert(sizeof(TelemetryRecord) == 40, "TelemetryRecord should have no padding");
+
+
+// Records fixed-size binary samples into a RAM ring buffer from the control loop, and writes
+//   them to the SD card only after a debugger run has finished (or aborted), so logging never
+//   changes the timing of the run.
+//
+// The file starts with a "TLM <version> <record size> <count> <loops>" line. Then comes one
+//   "LOOP <name> <iterations> <overruns> <rate Hz> <p50> <p90> <p99>" line per LoopMonitor,
+//   giving the time between iterations in microseconds, so the records can be read knowing
+//   the rate the loops actually ran at. Then come any lines written by onFlush, e.g. a
+//   "MEM <stack peak> <heap peak> <min free>" line from MemInfo::writeTelemetry(). Last is
+//   one line of hex per record.
+//
+// Recording does nothing until enable() is called, so libraries can record unconditionally
+//   and apps choose whether to pay for it.
+class Telemetry {
+public:
+
+    // Starts recording. The ring is cleared at the start of each debugger run and written to
+    //   TELEMETRY_FILE at the end of it.
+    static void enable();
+
+    static bool isEnabled();
+
+    // If set, called with every record, even when recording isn't enabled. Used by
+    //   UartStream to send records live.
+    static void (*onRecord)(const TelemetryRecord& r);
+
+    // If set, called by flush() after the LOOP lines, to add lines of its own to the file.
+    //   Each line should start with a word that says what it holds. Apps set this to
+    //   MemInfo::writeTelemetry to log memory use, so Telemetry doesn't depend on MemInfo.
+    static void (*onFlush)(FEHFile* file);
+
+    // Appends a record, overwriting the oldest one if the ring is full. The record is skipped
+    //   if the last one kept is less than TELEMETRY_PERIOD_MS older and has the same motor
+    //   powers, so changes of power are never lost. A comparison, a struct copy and an index
+    //   increment, so it is cheap enough for the inner loop.
+    static void record(const TelemetryRecord& r);
+
+    // Throws away every record.
+    static void clear();
+
+    // How many records are in the ring (at most TELEMETRY_CAPACITY).
+    static int count();
+
+    // Copies the i-th oldest record in the ring. Returns false if there is no such record.
+    static bool get(int i, TelemetryRecord* out);
+
+    // Writes the ring to TELEMETRY_FILE. Returns false if the file couldn't be opened. Slow;
+    //   only call this when nothing time-sensitive is running.
+    static bool flush();
+
+
+private:
+    static TelemetryRecord records[TELEMETRY_CAPACITY];
+    // Total records ever written since the last clear; the next one goes at head % capacity
+    static uint32_t head;
+    static bool enabled;
+
+    static void flushIfRecorded();
+};
+
+#endif
@@ -0,0 +1 @@
+telemetry_LIBS := debugger loopmonitor
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "ticker.hpp"
+
+#include "spsc.hpp"
+
+#include "stddef.h"
+
+
+// Cortex-M4 system registers (ARMv7-M Architecture Reference Manual, B3.3 and B3.2.12)
+static volatile uint32_t* const sysTickControl = (volatile uint32_t*) 0xE000E010;
+static volatile uint32_t* const sysTickReload = (volatile uint32_t*) 0xE000E014;
+static volatile uint32_t* const sysTickCurrent = (volatile uint32_t*) 0xE000E018;
+static volatile uint32_t* const systemHandlerPriority3 = (volatile uint32_t*) 0xE000ED20;
+
+// ENABLE | TICKINT | CLKSOURCE (core clock)
+#define SYSTICK_START 0x7u
+
+
+// Static variable definitions
+
+volatile uint32_t Ticker::ticks = 0;
+bool Ticker::running = false;
+
+void (*Ticker::tasks[MAX_TICKER_TASKS])() = {0};
+int Ticker::taskPeriods[MAX_TICKER_TASKS] = {0};
+int Ticker::taskCountdowns[MAX_TICKER_TASKS] = {0};
+volatile int Ticker::taskCount = 0;
+
+void (*volatile Ticker::pcSampler)(uint32_t pc) = NULL;
+
+
+// Function definitions
+
+// frame is the exception frame the hardware pushed when SysTick interrupted the program;
+//   frame[6] is the address it was interrupted at.
+extern "C" void tickerInterrupt(const uint32_t* frame) {
+    Ticker::handleTick(frame[6]);
+}
+
+// Passes whichever stack the interrupted code was using (bit 2 of the EXC_RETURN value in lr
+//   says which) on to tickerInterrupt(). Naked, so nothing is pushed before the stack pointer
+//   is read.
+extern "C" __attribute__((naked)) void SysTick_Handler() {
+    __asm volatile(
+        "tst lr, #4\n"
+        "ite eq\n"
+        "mrseq r0, msp\n"
+        "mrsne r0, psp\n"
+        "b tickerInterrupt\n"
+    );
+}
+
+bool Ticker::addTask(void (*task)(), int periodMs) {
+    if (taskCount >= MAX_TICKER_TASKS) return false;
+
+    int ticksPerPeriod = periodMs * TICKER_FREQUENCY_HZ / 1000;
+    if (ticksPerPeriod < 1) ticksPerPeriod = 1;
+
+    // Fill in the slot before the interrupt can see it
+    tasks[taskCount] = task;
+    taskPeriods[taskCount] = ticksPerPeriod;
+    taskCountdowns[taskCount] = ticksPerPeriod;
+    MEMORY_BARRIER();
+    taskCount = taskCount + 1;
+
+    if (!running) start();
+    return true;
+}
+
+void Ticker::setPcSampler(void (*sampler)(uint32_t pc)) {
+    pcSampler = sampler;
+    if (sampler != NULL && !running) start();
+}
+
+uint32_t Ticker::millis() {
+    return ticks * (1000 / TICKER_FREQUENCY_HZ);
+}
+
+bool Ticker::isRunning() {
+    return running;
+}
+
+void Ticker::start() {
+    running = true;
+
+    // Lowest priority (the K60 implements the top 4 bits) so SysTick never delays the
+    //   firmware's encoder or XBee interrupts
+    *systemHandlerPriority3 = (*systemHandlerPriority3 & 0x00FFFFFFu) | 0xF0000000u;
+
+    *sysTickReload = CORE_CLOCK_HZ / TICKER_FREQUENCY_HZ - 1;
+    *sysTickCurrent = 0;
+    *sysTickControl = SYSTICK_START;
+}
+
+void Ticker::handleTick(uint32_t interruptedPc) {
+    ticks = ticks + 1;
+
+    void (*sampler)(uint32_t pc) = pcSampler;
+    if (sampler != NULL) (*sampler)(interruptedPc);
+
+    int count = taskCount;
+    for (int i = 0; i < count; i++) {
+        if (--taskCountdowns[i] <= 0) {
+            taskCountdowns[i] = taskPeriods[i];
+            (*tasks[i])();
+        }
+    }
+}
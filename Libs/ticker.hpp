@@ -0,0 +1,58 @@
+#ifndef TICKER_HPP
+#define TICKER_HPP
+
+#include "stdint.h"
+
+#include "cycles.hpp"
+
+
+// How often the SysTick interrupt fires. Task periods are whole multiples of this.
+#define TICKER_FREQUENCY_HZ 1000
+
+#define MAX_TICKER_TASKS 8
+
+
+// Runs short background tasks at fixed rates from the Cortex-M4 SysTick interrupt. The
+//   Proteus firmware keeps time with the PIT, so SysTick is free for us.
+//
+// Tasks run with interrupts from the firmware (encoders, XBee) still enabled, since SysTick
+//   is given the lowest priority. They must be short, must not block, and must not call
+//   anything the main loop might be in the middle of (LCD drawing, SD access). Anything
+//   they share with the main loop should go through spsc.hpp.
+class Ticker {
+public:
+
+    // Calls task from the SysTick interrupt every periodMs milliseconds. The first call
+    //   starts the SysTick timer. Returns false if there are already MAX_TICKER_TASKS tasks.
+    static bool addTask(void (*task)(), int periodMs);
+
+    // Milliseconds since the ticker was started. Wraps after about 49 days.
+    static uint32_t millis();
+
+    // Whether the SysTick timer has been started.
+    static bool isRunning();
+
+    // Calls sampler from the SysTick interrupt on every tick with the address the main program
+    //   was interrupted at, for statistical profiling. Because SysTick has the lowest priority,
+    //   this is never an address inside another interrupt handler. Pass NULL to stop.
+    static void setPcSampler(void (*sampler)(uint32_t pc));
+
+    // Runs due tasks. Called from the SysTick interrupt handler; do not call directly.
+    static void handleTick(uint32_t interruptedPc);
+
+
+private:
+    static volatile uint32_t ticks;
+    static bool running;
+
+    static void (*tasks[MAX_TICKER_TASKS])();
+    static int taskPeriods[MAX_TICKER_TASKS];
+    static int taskCountdowns[MAX_TICKER_TASKS];
+    static volatile int taskCount;
+
+    static void (*volatile pcSampler)(uint32_t pc);
+
+    static void start();
+};
+
+#endif
@@ -0,0 +1,242 @@
+#include "timeline.hpp"
+
+#include "debugger.hpp"
+#include "format.hpp"
+
+#include "string.h"
+
+#include "FEHLCD.h"
+#include "FEHSD.h"
+#include "FEHUtility.h"
+
+
+// How many rows fit on the report under the column headings, including the total
+#define TIMELINE_REPORT_ROWS 10
+#define TIMELINE_ROW_HEIGHT 17
+
+// Longest phase name read back from TIMELINE_FILE
+#define TIMELINE_NAME_SIZE 32
+
+
+// Static variable definitions
+
+TimelinePhase Timeline::phases[MAX_TIMELINE_PHASES];
+int Timeline::phaseCount = 0;
+bool Timeline::phaseOpen = false;
+double Timeline::phaseStartTime = 0;
+bool Timeline::handlersAdded = false;
+
+uint32_t Timeline::history[MAX_TIMELINE_PHASES][TIMELINE_HISTORY];
+int Timeline::historyCount[MAX_TIMELINE_PHASES] = {0};
+uint32_t Timeline::totalHistory[TIMELINE_HISTORY];
+int Timeline::totalHistoryCount = 0;
+int Timeline::runNumber = 0;
+
+
+// Function definitions
+
+void Timeline::runPhase(const char* name, void (*phase)()) {
+    beginPhase(name);
+    (*phase)();
+    endPhase();
+}
+
+void Timeline::beginPhase(const char* name) {
+    // The first phase hooks the timeline into the debugger, so the run it is part of still
+    //   gets saved
+    if (!handlersAdded) {
+        handlersAdded = true;
+        Debugger::addStartHandler(&startRun);
+        Debugger::addFinishHandler(&finishRun);
+    }
+
+    if (phaseOpen) closePhase(true);
+    if (phaseCount >= MAX_TIMELINE_PHASES) return;
+
+    TimelinePhase& p = phases[phaseCount];
+    p.name = name;
+    p.durationMs = 0;
+    p.corrections = 0;
+    p.timeouts = 0;
+    p.finished = false;
+    phaseOpen = true;
+    phaseStartTime = TimeNow();
+}
+
+void Timeline::endPhase() {
+    if (phaseOpen) closePhase(true);
+}
+
+void Timeline::closePhase(bool finished) {
+    TimelinePhase& p = phases[phaseCount];
+    p.durationMs = (uint32_t) ((TimeNow() - phaseStartTime) * 1000);
+    p.finished = finished;
+    phaseOpen = false;
+    phaseCount++;
+}
+
+void Timeline::noteCorrection() {
+    if (phaseOpen) phases[phaseCount].corrections++;
+}
+
+void Timeline::noteTimeout() {
+    if (phaseOpen) phases[phaseCount].timeouts++;
+}
+
+const char* Timeline::currentPhase() {
+    return phaseOpen ? phases[phaseCount].name : NULL;
+}
+
+void Timeline::startRun() {
+    phaseCount = 0;
+    phaseOpen = false;
+}
+
+void Timeline::finishRun() {
+    // A phase that is still open was cut short by an abort or a failed assertion
+    if (phaseOpen) closePhase(false);
+    if (phaseCount == 0) return;
+
+    loadHistory();
+    saveRun();
+}
+
+void Timeline::loadHistory() {
+    for (int i = 0; i < phaseCount; i++) {
+        historyCount[i] = 0;
+    }
+    totalHistoryCount = 0;
+    runNumber = 0;
+
+    FEHFile* file = SD.FOpen(TIMELINE_FILE, "r");
+    if (file == NULL) return;
+
+    // Lines for one run are next to each other, so a run's total is known once the next run
+    //   starts
+    int run = 0, lineRun, corrections, timeouts, finished;
+    unsigned long durationMs;
+    char name[TIMELINE_NAME_SIZE];
+    uint32_t runTotal = 0;
+    bool runFinished = false;
+    bool more = true;
+    while (more) {
+        more = !SD.FEof(file) && SD.FScanf(file, "%i %31s %lu %i %i %i", &lineRun, name, &durationMs,
+                                            &corrections, &timeouts, &finished) == 6;
+
+        if (!more || lineRun != run) {
+            if (run != 0 && runFinished) {
+                totalHistory[totalHistoryCount % TIMELINE_HISTORY] = runTotal;
+                totalHistoryCount++;
+            }
+            if (!more) break;
+            run = lineRun;
+            if (run > runNumber) runNumber = run;
+            runTotal = 0;
+            runFinished = true;
+        }
+
+        runTotal += (uint32_t) durationMs;
+        if (!finished) runFinished = false;
+        if (!finished) continue;
+
+        for (int i = 0; i < phaseCount; i++) {
+            if (strcmp(name, phases[i].name) == 0) {
+                history[i][historyCount[i] % TIMELINE_HISTORY] = (uint32_t) durationMs;
+                historyCount[i]++;
+                break;
+            }
+        }
+    }
+
+    SD.FClose(file);
+}
+
+void Timeline::saveRun() {
+    runNumber++;
+
+    FEHFile* file = SD.FOpen(TIMELINE_FILE, "a");
+    if (file == NULL) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printNextLine("Phases not saved");
+        Debugger::setFontColor();
+        return;
+    }
+    for (int i = 0; i < phaseCount; i++) {
+        TimelinePhase& p = phases[i];
+        SD.FPrintf(file, "%i %s %lu %i %i %i\n", runNumber, p.name, (unsigned long) p.durationMs,
+                   p.corrections, p.timeouts, p.finished ? 1 : 0);
+    }
+    SD.FClose(file);
+}
+
+uint32_t Timeline::best(const uint32_t* durations, int count) {
+    if (count > TIMELINE_HISTORY) count = TIMELINE_HISTORY;
+    uint32_t result = durations[0];
+    for (int i = 1; i < count; i++) {
+        if (durations[i] < result) result = durations[i];
+    }
+    return result;
+}
+
+uint32_t Timeline::median(const uint32_t* durations, int count) {
+    if (count > TIMELINE_HISTORY) count = TIMELINE_HISTORY;
+    uint32_t sorted[TIMELINE_HISTORY];
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && sorted[j - 1] > durations[i]) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = durations[i];
+    }
+    return sorted[count / 2];
+}
+
+void Timeline::drawRow(int row, const char* name, bool finished, uint32_t nowMs,
+                       const uint32_t* durations, int count) {
+    // Unfinished phases are marked with a !
+    char buf[WIDTH_CHARS + 1];
+    if (count > 0) {
+        Format::print(buf, sizeof(buf), "%-10.10s%c%5.1f%5.1f%5.1f", name, finished ? ' ' : '!',
+                      nowMs / 1000.0, best(durations, count) / 1000.0, median(durations, count) / 1000.0);
+    } else {
+        Format::print(buf, sizeof(buf), "%-10.10s%c%5.1f    -    -", name, finished ? ' ' : '!',
+                      nowMs / 1000.0);
+    }
+    LCD.WriteAt(buf, 4, 40 + TIMELINE_ROW_HEIGHT*(row + 1));
+}
+
+void Timeline::drawReport() {
+    if (phaseCount == 0) {
+        LCD.WriteAt("No phases timed yet.", 16, 40);
+        return;
+    }
+
+    LCD.WriteAt(" now best  med", 4 + 12*11, 40);
+
+    uint32_t total = 0;
+    bool allFinished = true;
+    for (int i = 0; i < phaseCount; i++) {
+        total += phases[i].durationMs;
+        if (!phases[i].finished) allFinished = false;
+    }
+    drawRow(0, "TOTAL", allFinished, total, totalHistory, totalHistoryCount);
+
+    // If there are too many phases, the last row sums up the ones that don't fit
+    int shown = phaseCount < TIMELINE_REPORT_ROWS - 1 ? phaseCount : TIMELINE_REPORT_ROWS - 2;
+    for (int i = 0; i < shown; i++) {
+        drawRow(i + 1, phases[i].name, phases[i].finished, phases[i].durationMs, history[i],
+                historyCount[i]);
+    }
+    if (shown < phaseCount) {
+        uint32_t rest = 0;
+        bool restFinished = true;
+        for (int i = shown; i < phaseCount; i++) {
+            rest += phases[i].durationMs;
+            if (!phases[i].finished) restFinished = false;
+        }
+        char name[WIDTH_CHARS + 1];
+        Format::print(name, sizeof(name), "+%i more", phaseCount - shown);
+        drawRow(shown + 1, name, restFinished, rest, NULL, 0);
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef TIMELINE_HPP
+#define TIMELINE_HPP
+
+#include "stdint.h"
+
+
+#define MAX_TIMELINE_PHASES 16
+
+// How many previous runs of each phase the comparison covers
+#define TIMELINE_HISTORY 32
+
+// File on the SD card that every run is appended to
+#define TIMELINE_FILE "PHASES.TXT"
+
+
+// One phase of the current run.
+struct TimelinePhase {
+    const char* name;
+    uint32_t durationMs;
+    // RPS line-up iterations and movement timeouts during the phase
+    int corrections;
+    int timeouts;
+    // False if the run was aborted (or failed an assertion) during the phase
+    bool finished;
+};
+
+
+// Times the phases of a course run. Each debugger run that has phases is appended to
+//   TIMELINE_FILE, one "<run> <phase> <ms> <corrections> <timeouts> <finished>" line per phase,
+//   and the "Phases" report shows the last run's phase times next to the best and median times
+//   of previous runs, so it's easy to see which phase is slow or inconsistent.
+//
+// Phase names must be string literals without spaces. Phases can't be nested; beginning a
+//   phase ends the current one.
+class Timeline {
+public:
+
+    // Runs phase as a phase with the given name.
+    static void runPhase(const char* name, void (*phase)());
+
+    static void beginPhase(const char* name);
+    static void endPhase();
+
+    // Counted against the current phase. Navigation calls these for every RPS line-up
+    //   iteration and every movement that times out.
+    static void noteCorrection();
+    static void noteTimeout();
+
+    // The phase that is running, or NULL.
+    static const char* currentPhase();
+
+    // Draws the last run against previous runs, for use with ProteOS::registerReport().
+    static void drawReport();
+
+
+private:
+    static TimelinePhase phases[MAX_TIMELINE_PHASES];
+    static int phaseCount;
+    static bool phaseOpen;
+    static double phaseStartTime;
+    static bool handlersAdded;
+
+    // Durations of each of this run's phases in previous runs, oldest overwritten first
+    static uint32_t history[MAX_TIMELINE_PHASES][TIMELINE_HISTORY];
+    static int historyCount[MAX_TIMELINE_PHASES];
+    // Total durations of previous runs that finished every phase
+    static uint32_t totalHistory[TIMELINE_HISTORY];
+    static int totalHistoryCount;
+    static int runNumber;
+
+    static void startRun();
+    static void finishRun();
+    static void closePhase(bool finished);
+    static void loadHistory();
+    static void saveRun();
+
+    static void drawRow(int row, const char* name, bool finished, uint32_t nowMs,
+                        const uint32_t* durations, int count);
+
+    static uint32_t best(const uint32_t* durations, int count);
+    static uint32_t median(const uint32_t* durations, int count);
+};
+
+#endif
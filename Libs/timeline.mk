@@ -0,0 +1 @@
+timeline_LIBS := debugger format
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "tracelog.hpp"
+
+#include "debugger.hpp"
+#include "format.hpp"
+#include "ticker.hpp"
+
+#include "stddef.h"
+
+#include "FEHLCD.h"
+#include "FEHSD.h"
+
+
+// How many entries the report shows
+#define TRACE_REPORT_LINES 9
+
+// Longest conversion spec format() copies, like "%-08.3f"
+#define TRACE_SPEC_SIZE 16
+
+
+// Static variable definitions
+
+TraceEntry TraceLog::entries[TRACE_CAPACITY];
+uint32_t TraceLog::head = 0;
+bool TraceLog::enabled = false;
+
+
+// Function definitions
+
+void TraceLog::enable() {
+    if (enabled) return;
+    enabled = true;
+    Debugger::addStartHandler(&clear);
+    Debugger::addFinishHandler(&flushIfLogged);
+}
+
+uint32_t TraceLog::now() {
+    return Ticker::millis();
+}
+
+void TraceLog::clear() {
+    head = 0;
+}
+
+int TraceLog::count() {
+    return head < TRACE_CAPACITY ? (int) head : TRACE_CAPACITY;
+}
+
+bool TraceLog::get(int i, TraceEntry* out) {
+    if (i < 0 || i >= count()) return false;
+    uint32_t oldest = head - (uint32_t) count();
+    *out = entries[(oldest + (uint32_t) i) & (TRACE_CAPACITY - 1)];
+    return true;
+}
+
+int TraceLog::format(const TraceEntry& entry, char* buf, int size) {
+    if (size <= 0) return 0;
+    int len = 0;
+    int arg = 0;
+    const char* f = entry.format;
+
+    while (*f != '\0' && len < size - 1) {
+        if (*f != '%') {
+            buf[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            buf[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy the spec without its length modifiers, since every argument is a single word
+        char spec[TRACE_SPEC_SIZE];
+        int specLen = 0;
+        spec[specLen++] = *f++;
+        while (*f != '\0' && strchr("-+ #0123456789.hlLzjt", *f) != NULL) {
+            if (strchr("hlLzjt", *f) == NULL && specLen < TRACE_SPEC_SIZE - 2) {
+                spec[specLen++] = *f;
+            }
+            f++;
+        }
+        char conversion = *f;
+        if (conversion == '\0') break;
+        f++;
+        spec[specLen++] = conversion;
+        spec[specLen] = '\0';
+
+        if (arg >= entry.argCount) {
+            // More conversions than arguments; show where instead of reading garbage
+            len += Format::print(buf + len, size - len, "?");
+            continue;
+        }
+        uintptr_t word = entry.args[arg++];
+
+        int written;
+        switch (conversion) {
+        case 'd': case 'i': case 'c':
+            written = Format::print(buf + len, size - len, spec, (int) word);
+            break;
+        case 'u': case 'o': case 'x': case 'X':
+            written = Format::print(buf + len, size - len, spec, (unsigned int) word);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+            uint32_t bits = (uint32_t) word;
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            written = Format::print(buf + len, size - len, spec, (double) value);
+            break;
+        }
+        case 's':
+            written = Format::print(buf + len, size - len, spec, (const char*) word);
+            break;
+        case 'p':
+            written = Format::print(buf + len, size - len, spec, (void*) word);
+            break;
+        default:
+            written = Format::print(buf + len, size - len, "?");
+            break;
+        }
+        if (written > 0) len += written;
+    }
+
+    // Format::print() reports the length it wanted, which may be past the end
+    if (len > size - 1) len = size - 1;
+    buf[len] = '\0';
+    return len;
+}
+
+bool TraceLog::flush() {
+    FEHFile* file = SD.FOpen(TRACE_FILE, "w");
+    if (file == NULL) return false;
+
+    char line[128];
+    TraceEntry e;
+    int n = count();
+    for (int i = 0; i < n; i++) {
+        get(i, &e);
+        format(e, line, sizeof(line));
+        SD.FPrintf(file, "%8lu %s\n", (unsigned long) e.timeMs, line);
+    }
+
+    SD.FClose(file);
+    return true;
+}
+
+void TraceLog::flushIfLogged() {
+    // Don't overwrite the last useful log with an empty one
+    if (head == 0) return;
+    if (!flush()) {
+        Debugger::setFontColor(Debugger::errorColor);
+        Debugger::printNextLine("Trace not saved");
+        Debugger::setFontColor();
+    }
+}
+
+void TraceLog::drawReport() {
+    char buf[WIDTH_CHARS + 1];
+    TraceEntry e;
+
+    int n = count();
+    int first = n > TRACE_REPORT_LINES ? n - TRACE_REPORT_LINES : 0;
+    for (int i = first; i < n; i++) {
+        get(i, &e);
+        format(e, buf, sizeof(buf));
+        LCD.WriteAt(buf, 4, 40 + 20*(i - first));
+    }
+
+    if (n == 0) {
+        LCD.WriteAt("Nothing traced.", 16, 40);
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef TRACELOG_HPP
+#define TRACELOG_HPP
+
+#include "stdint.h"
+#include "string.h"
+
+
+// How many entries the log keeps before overwriting the oldest (must be a power of two)
+#define TRACE_CAPACITY 128
+
+// The most arguments one TRACE() call can have
+#define TRACE_MAX_ARGS 4
+
+// File on the SD card the formatted log is written to after each debugger run
+#define TRACE_FILE "TRACE.TXT"
+
+
+// Logs a printf-style message without formatting it. Only the format string's address and
+//   the raw argument words are stored, so this costs about as much as a few assignments;
+//   the text is made later by TraceLog::format(). Define NO_TRACE to compile every call out.
+//
+// The format string and any %s arguments must stay valid until the log is read (string
+//   literals are fine, stack buffers are not). Floats are stored as single precision.
+//   Supports the d, i, u, o, x, X, c, s, p, f, F, e, E, g, G and % conversions, with
+//   flags, width and precision, but not '*'.
+#ifdef NO_TRACE
+#define TRACE(...)  ((void) 0)
+#else
+#define TRACE(...)  TraceLog::log(__VA_ARGS__)
+#endif
+
+
+struct TraceEntry {
+    const char* format;
+    // Ticker::millis() when the entry was logged
+    uint32_t timeMs;
+    int argCount;
+    uintptr_t args[TRACE_MAX_ARGS];
+};
+
+
+// Turns one argument into a raw word. The format string says how to read it back.
+inline uintptr_t traceWord(int v) { return (uintptr_t) v; }
+inline uintptr_t traceWord(unsigned int v) { return (uintptr_t) v; }
+inline uintptr_t traceWord(long v) { return (uintptr_t) v; }
+inline uintptr_t traceWord(unsigned long v) { return (uintptr_t) v; }
+inline uintptr_t traceWord(const char* v) { return (uintptr_t) v; }
+inline uintptr_t traceWord(const void* v) { return (uintptr_t) v; }
+inline uintptr_t traceWord(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+inline uintptr_t traceWord(double v) { return traceWord((float) v); }
+
+
+// A RAM log for code that is too time-sensitive for the Debugger's print functions.
+//   Formatting happens only when the log is read: in the "Trace" report, or when it is
+//   written to TRACE_FILE after a debugger run.
+//
+// Only log from the main program, not from interrupts.
+class TraceLog {
+public:
+
+    // Starts logging. The log is cleared at the start of each debugger run and written to
+    //   TRACE_FILE at the end of it. Until this is called, TRACE() does nothing.
+    static void enable();
+
+    // Use the TRACE() macro instead, so logging can be compiled out.
+    template <typename... Args>
+    static void log(const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= TRACE_MAX_ARGS, "Too many arguments for TRACE()");
+        if (!enabled) return;
+        TraceEntry& e = entries[head & (TRACE_CAPACITY - 1)];
+        e.format = format;
+        e.timeMs = now();
+        e.argCount = (int) sizeof...(Args);
+        storeArgs(e.args, args...);
+        head++;
+    }
+
+    // Throws away every entry.
+    static void clear();
+
+    // How many entries are in the log (at most TRACE_CAPACITY).
+    static int count();
+
+    // Copies the i-th oldest entry. Returns false if there is no such entry.
+    static bool get(int i, TraceEntry* out);
+
+    // Formats an entry into buf, which holds size chars including the terminator. Returns the
+    //   length of the text written.
+    static int format(const TraceEntry& entry, char* buf, int size);
+
+    // Writes every entry, formatted, to TRACE_FILE. Returns false if the file couldn't be
+    //   opened.
+    static bool flush();
+
+    // Draws the newest entries, for use with ProteOS::registerReport().
+    static void drawReport();
+
+
+private:
+    static TraceEntry entries[TRACE_CAPACITY];
+    static uint32_t head;
+    static bool enabled;
+
+    static uint32_t now();
+    static void flushIfLogged();
+
+    static void storeArgs(uintptr_t*) {}
+
+    template <typename T, typename... Rest>
+    static void storeArgs(uintptr_t* out, T first, Rest... rest) {
+        *out = traceWord(first);
+        storeArgs(out + 1, rest...);
+    }
+};
+
+#endif
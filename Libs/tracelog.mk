@@ -0,0 +1 @@
+tracelog_LIBS := debugger format ticker
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "uartstream.hpp"
+
+#include "ticker.hpp"
+
+#include "stddef.h"
+
+#include "uart.h"
+
+
+// Static variable definitions
+
+FrameQueue<UART_STREAM_CAPACITY> UartStream::queue;
+const ByteTransport UartStream::uartTransport = { &UartStream::uartCanWrite, &UartStream::uartWriteByte };
+const ByteTransport* volatile UartStream::transport = &UartStream::uartTransport;
+bool UartStream::started = false;
+uint32_t UartStream::lastTelemetryMs = 0;
+
+
+// Function definitions
+
+void UartStream::begin() {
+    if (started) return;
+    started = true;
+
+    if (transport == &uartTransport) {
+        uart_init(UART_STREAM_PORT, UART_STREAM_CLOCK_KHZ, UART_STREAM_BAUD);
+    }
+    Telemetry::onRecord = &sendTelemetry;
+    Ticker::addTask(&drain, 1);
+}
+
+void UartStream::setTransport(const ByteTransport* transport_) {
+    transport = transport_;
+}
+
+bool UartStream::send(uint8_t type, const void* payload, int length) {
+    return queue.send(type, payload, length);
+}
+
+void UartStream::sendTelemetry(const TelemetryRecord& r) {
+    if (r.timeMs - lastTelemetryMs < UART_STREAM_PERIOD_MS) return;
+    lastTelemetryMs = r.timeMs;
+    send(FRAME_TYPE_TELEMETRY, &r, sizeof(r));
+}
+
+uint32_t UartStream::getDroppedFrames() {
+    return queue.getDroppedFrames();
+}
+
+void UartStream::drain() {
+    queue.drain(*transport, UART_STREAM_BYTES_PER_TICK);
+}
+
+bool UartStream::uartCanWrite() {
+    return (UART_S1_REG(UART_STREAM_PORT) & UART_S1_TDRE_MASK) != 0;
+}
+
+void UartStream::uartWriteByte(uint8_t byte) {
+    UART_D_REG(UART_STREAM_PORT) = byte;
+}
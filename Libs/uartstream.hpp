@@ -0,0 +1,71 @@
+#ifndef UARTSTREAM_HPP
+#define UARTSTREAM_HPP
+
+#include "stdint.h"
+
+#include "framequeue.hpp"
+#include "telemetry.hpp"
+
+
+// The UART the stream is sent on, and its settings. The port must not be one the firmware
+//   already uses: UART5 talks to the propeller, and RPS has its own XBee UART.
+#ifndef UART_STREAM_PORT
+#define UART_STREAM_PORT UART2_BASE_PTR
+#endif
+#define UART_STREAM_BAUD 115200
+// UART2 to UART5 are clocked from the bus clock, which runs at half the core clock
+#define UART_STREAM_CLOCK_KHZ (CORE_CLOCK_HZ / 2 / 1000)
+
+// Bytes that can be waiting to be sent (must be a power of two)
+#define UART_STREAM_CAPACITY 512
+
+// Most bytes handed to the transport per ticker tick, to keep the interrupt short
+#define UART_STREAM_BYTES_PER_TICK 16
+
+// Shortest time between telemetry frames, in milliseconds. A UART without a FIFO only takes
+//   a byte or two per tick, so this keeps the stream well under what it can carry.
+#define UART_STREAM_PERIOD_MS 50
+
+
+// Sends frames (see frame.hpp) to a laptop in the background, so tuning values can be
+//   watched live. Frames are queued whole in a FrameQueue and sent by a ticker task whenever
+//   the transport has room, so sending never waits on the UART. If the queue is too full for
+//   a frame, the frame is dropped rather than sent in part. The transport's functions are
+//   called from the SysTick interrupt.
+//
+// Decode the stream on the laptop with Tools/tlmrecv. tlmrecv --loopback runs the same
+//   FrameQueue over a pseudo-terminal.
+class UartStream {
+public:
+
+    // Starts streaming telemetry records (at most one per UART_STREAM_PERIOD_MS) over
+    //   UART_STREAM_PORT, or over the transport given to setTransport().
+    static void begin();
+
+    // Sends over a different transport instead of the UART. Can be called at any time; the
+    //   transport must live forever.
+    static void setTransport(const ByteTransport* transport);
+
+    // Queues one frame. Returns false if it was dropped. Only call from the main program.
+    static bool send(uint8_t type, const void* payload, int length);
+
+    // Queues a telemetry frame, unless one was sent less than UART_STREAM_PERIOD_MS ago.
+    static void sendTelemetry(const TelemetryRecord& r);
+
+    // How many frames were dropped because the queue was full.
+    static uint32_t getDroppedFrames();
+
+
+private:
+    static FrameQueue<UART_STREAM_CAPACITY> queue;
+    static const ByteTransport* volatile transport;
+    static const ByteTransport uartTransport;
+    static bool started;
+    static uint32_t lastTelemetryMs;
+
+    static void drain();
+    static bool uartCanWrite();
+    static void uartWriteByte(uint8_t byte);
+};
+
+#endif
@@ -0,0 +1 @@
+uartstream_LIBS := telemetry ticker
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "varstore.hpp"
+
+#include "format.hpp"
+#include "frame.hpp"
+
+#include "stddef.h"
+#include "string.h"
+
+#include "FEHSD.h"
+
+
+// Bytes in the header and in each entry of a record
+#define RECORD_HEADER_SIZE 6
+#define RECORD_ENTRY_SIZE 9
+
+// Longest file name VARSTORE_FILE_FORMAT makes, including the terminator
+#define FILE_NAME_SIZE 16
+
+// Reads a line of up to 2 * VARSTORE_LINE_BYTES hex digits
+#define LINE_SCAN_FORMAT "%64s"
+
+
+// The hex-encoded bytes of a record being written, a line at a time
+struct HexWriter {
+    FEHFile* file;
+    char line[2*VARSTORE_LINE_BYTES + 1];
+    int length;
+    uint16_t crc;
+};
+
+// The bytes of a record being read back
+struct HexReader {
+    FEHFile* file;
+    char line[2*VARSTORE_LINE_BYTES + 1];
+    int pos;
+    uint16_t crc;
+};
+
+
+// Function definitions
+
+static FEHFile* openFile(const char* app, int preset, const char* mode) {
+    if (app == NULL || preset < 0 || preset >= VARSTORE_PRESETS) return NULL;
+    char name[FILE_NAME_SIZE];
+    Format::print(name, FILE_NAME_SIZE, VARSTORE_FILE_FORMAT,
+                  VarStore::hashName(app) & VARSTORE_TAG_MASK, preset);
+    return SD.FOpen(name, mode);
+}
+
+static void writeByte(HexWriter& w, uint8_t b) {
+    static const char digits[] = "0123456789ABCDEF";
+    w.crc = frameCrc(&b, 1, w.crc);
+    w.line[w.length] = digits[b >> 4];
+    w.line[w.length + 1] = digits[b & 0xF];
+    w.length += 2;
+    if (w.length == 2*VARSTORE_LINE_BYTES) {
+        w.line[w.length] = '\0';
+        SD.FPrintf(w.file, "%s\n", w.line);
+        w.length = 0;
+    }
+}
+
+static void writeU32(HexWriter& w, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        writeByte(w, (uint8_t) (v >> (8*i)));
+    }
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static bool readByte(HexReader& r, uint8_t* out) {
+    if (r.line[r.pos] == '\0') {
+        if (SD.FEof(r.file) || SD.FScanf(r.file, LINE_SCAN_FORMAT, r.line) != 1) return false;
+        r.pos = 0;
+    }
+    // A line with an odd number of digits ends in the middle of a byte, and fails here
+    int high = hexValue(r.line[r.pos]);
+    int low = hexValue(r.line[r.pos + 1]);
+    if (high < 0 || low < 0) return false;
+    r.pos += 2;
+
+    *out = (uint8_t) (high << 4 | low);
+    r.crc = frameCrc(out, 1, r.crc);
+    return true;
+}
+
+static bool readBytes(HexReader& r, uint8_t* out, int length) {
+    for (int i = 0; i < length; i++) {
+        if (!readByte(r, &out[i])) return false;
+    }
+    return true;
+}
+
+static uint32_t getU32(const uint8_t* bytes) {
+    return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+// Opens a preset and reads its header. Returns the number of entries, or -1 (with the file
+//   closed) if the preset is missing or isn't a record this version understands.
+static int openRecord(const char* app, int preset, HexReader& r) {
+    r.file = openFile(app, preset, "r");
+    if (r.file == NULL) return -1;
+    r.line[0] = '\0';
+    r.pos = 0;
+    r.crc = 0xFFFF;
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    if (!readBytes(r, header, RECORD_HEADER_SIZE) || header[0] != 'P' || header[1] != 'V' ||
+        header[2] != 'S' || header[3] != VARSTORE_VERSION) {
+        SD.FClose(r.file);
+        return -1;
+    }
+    return header[4] | header[5] << 8;
+}
+
+// Reads the rest of a record after its header, and checks its CRC. Closes the file.
+static bool checkRecord(HexReader& r, int count) {
+    uint8_t entry[RECORD_ENTRY_SIZE];
+    bool ok = true;
+    for (int i = 0; i < count && ok; i++) {
+        ok = readBytes(r, entry, RECORD_ENTRY_SIZE);
+    }
+    uint16_t expected = r.crc;
+    uint8_t crc[2];
+    ok = ok && readBytes(r, crc, 2) && (crc[0] | crc[1] << 8) == expected;
+    SD.FClose(r.file);
+    return ok;
+}
+
+uint32_t VarStore::hashName(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; c++) {
+        hash ^= (uint8_t) *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool VarStore::save(const char* app, int preset, const ProteOSVariable* vars, int count) {
+    HexWriter w;
+    w.file = openFile(app, preset, "w");
+    if (w.file == NULL) return false;
+    w.length = 0;
+    w.crc = 0xFFFF;
+
+    writeByte(w, 'P');
+    writeByte(w, 'V');
+    writeByte(w, 'S');
+    writeByte(w, VARSTORE_VERSION);
+    writeByte(w, (uint8_t) (count & 0xFF));
+    writeByte(w, (uint8_t) (count >> 8));
+
+    for (int i = 0; i < count; i++) {
+        uint32_t value = 0;
+        switch (vars[i].type) {
+            case ProteOSVariable::Bool:
+                value = *((bool*) vars[i].ptr) ? 1 : 0;
+                break;
+            case ProteOSVariable::Int:
+                value = (uint32_t) *((int*) vars[i].ptr);
+                break;
+            case ProteOSVariable::Float:
+                memcpy(&value, vars[i].ptr, sizeof(value));
+                break;
+        }
+        writeU32(w, hashName(vars[i].name));
+        writeByte(w, (uint8_t) vars[i].type);
+        writeU32(w, value);
+    }
+
+    uint16_t crc = w.crc;
+    writeByte(w, (uint8_t) (crc & 0xFF));
+    writeByte(w, (uint8_t) (crc >> 8));
+    if (w.length > 0) {
+        w.line[w.length] = '\0';
+        SD.FPrintf(w.file, "%s\n", w.line);
+    }
+
+    SD.FClose(w.file);
+    return true;
+}
+
+int VarStore::entryCount(const char* app, int preset) {
+    HexReader r;
+    int count = openRecord(app, preset, r);
+    if (count < 0 || !checkRecord(r, count)) return -1;
+    return count;
+}
+
+int VarStore::load(const char* app, int preset, const ProteOSVariable* vars, int count) {
+    // Check the whole record first, so a half-written file can't change half the variables
+    int entries = entryCount(app, preset);
+    if (entries < 0) return -1;
+
+    HexReader r;
+    if (openRecord(app, preset, r) != entries) return -1;
+
+    int loaded = 0;
+    uint8_t entry[RECORD_ENTRY_SIZE];
+    for (int i = 0; i < entries && readBytes(r, entry, RECORD_ENTRY_SIZE); i++) {
+        uint32_t hash = getU32(entry);
+        uint32_t value = getU32(entry + 5);
+        for (int j = 0; j < count; j++) {
+            if ((uint8_t) vars[j].type != entry[4] || hashName(vars[j].name) != hash) continue;
+            switch (vars[j].type) {
+                case ProteOSVariable::Bool:
+                    *((bool*) vars[j].ptr) = value != 0;
+                    break;
+                case ProteOSVariable::Int:
+                    *((int*) vars[j].ptr) = (int) value;
+                    break;
+                case ProteOSVariable::Float:
+                    memcpy(vars[j].ptr, &value, sizeof(value));
+                    break;
+            }
+            loaded++;
+            break;
+        }
+    }
+
+    SD.FClose(r.file);
+    return loaded;
+}
@@ -0,0 +1,62 @@
+#ifndef VARSTORE_HPP
+#define VARSTORE_HPP
+
+#include "proteos.hpp"
+
+#include "stdint.h"
+
+
+// How many presets there are. Preset 0 is loaded when ProteOS starts, and is saved every time
+//   a variable is edited.
+#define VARSTORE_PRESETS 4
+#define VARSTORE_BOOT_PRESET 0
+
+// Files on the SD card the presets are saved in, by app tag and preset number. The tag is
+//   the low 24 bits of the app name's hash, which keeps the name within FAT's 8.3 limit.
+#define VARSTORE_FILE_FORMAT "P%06X%i.VAR"
+#define VARSTORE_TAG_MASK 0xFFFFFF
+
+// Bumped whenever the record layout changes; records with another version are ignored
+#define VARSTORE_VERSION 1
+
+// Bytes of the record written per line of the file
+#define VARSTORE_LINE_BYTES 32
+
+
+// Saves ProteOS variables to the SD card, and loads them back after a reset.
+//
+// Presets belong to one app: every app on the SD card has its own files, named after it, so
+//   saving in one app never overwrites another's tuning, and variables that happen to share
+//   a name (motorPower...) don't leak from one app into the next. app must be the same
+//   string every time the app runs; a NULL app has no presets.
+//
+// A preset is one binary record:
+//
+//   'P' 'V' 'S' <version> <count: u16> <count entries> <CRC: u16>
+//   entry: <FNV-1a hash of the name: u32> <type: u8> <value: u32>
+//
+// Numbers are little-endian, and the CRC is CRC-16/CCITT-FALSE (see frame.hpp) over
+//   everything before it. FEHSD can only read and write text, so the record is stored as hex,
+//   VARSTORE_LINE_BYTES to a line, and read back with one FScanf() per line rather than one
+//   per field. Variables are matched by name, so adding, removing, or reordering variables
+//   doesn't break a saved preset; entries for variables that no longer exist, or whose type
+//   changed, are skipped.
+class VarStore {
+public:
+
+    // Writes the current values of the variables to a preset. Returns false if the SD card
+    //   couldn't be written.
+    static bool save(const char* app, int preset, const ProteOSVariable* vars, int count);
+
+    // Sets every variable that was saved in a preset. Returns how many were set, or -1 if the
+    //   preset is missing or corrupt, in which case no variable is changed.
+    static int load(const char* app, int preset, const ProteOSVariable* vars, int count);
+
+    // How many variables are saved in a preset, or -1 if it is missing or corrupt.
+    static int entryCount(const char* app, int preset);
+
+    // 32-bit FNV-1a hash of a variable name.
+    static uint32_t hashName(const char* name);
+};
+
+#endif
@@ -0,0 +1 @@
+varstore_LIBS := format
\ No newline at end of file
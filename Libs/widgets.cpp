@@ -0,0 +1,371 @@
+#include "widgets.hpp"
+
+#include "stddef.h"
+#include "string.h"
+
+#include "FEHLCD.h"
+
+
+// Function definitions
+
+bool Rect::contains(float px, float py) const {
+    return px >= (float) x && px < (float) (x + width) && py >= (float) y && py < (float) (y + height);
+}
+
+bool Rect::intersects(const Rect& other) const {
+    return x < other.x + other.width && other.x < x + width &&
+           y < other.y + other.height && other.y < y + height;
+}
+
+
+Widget::Widget(int x, int y, int width, int height) {
+    bounds.x = x;
+    bounds.y = y;
+    bounds.width = width;
+    bounds.height = height;
+    visible = true;
+    dirty = true;
+    drawn = false;
+}
+
+const Rect& Widget::getBounds() const {
+    return bounds;
+}
+
+void Widget::setVisible(bool visible_) {
+    if (visible == visible_) return;
+    visible = visible_;
+    dirty = true;
+}
+
+bool Widget::isVisible() const {
+    return visible;
+}
+
+void Widget::invalidate() {
+    dirty = true;
+}
+
+
+Label::Label(int x, int y, int width, const char* text_, Align align_)
+    : Widget(x, y, width, WIDGET_CHAR_HEIGHT) {
+    text[0] = '\0';
+    align = align_;
+    setText(text_);
+}
+
+void Label::setText(const char* text_) {
+    if (strncmp(text, text_, WIDGET_TEXT_SIZE) == 0) return;
+    strncpy(text, text_, WIDGET_TEXT_SIZE);
+    text[WIDGET_TEXT_SIZE] = '\0';
+    invalidate();
+}
+
+void Label::setFormatList(const char* format, FormatArgList args) {
+    char buf[WIDGET_TEXT_SIZE + 1];
+    Format::printList(buf, sizeof(buf), format, args);
+    setText(buf);
+}
+
+const char* Label::getText() const {
+    return text;
+}
+
+void Label::draw() {
+    // Cut the text off at the edge of the label, so it never draws over its neighbours
+    char buf[WIDGET_TEXT_SIZE + 1];
+    int fit = bounds.width / WIDGET_CHAR_WIDTH;
+    if (fit > WIDGET_TEXT_SIZE) fit = WIDGET_TEXT_SIZE;
+    strncpy(buf, text, (size_t) fit);
+    buf[fit] = '\0';
+
+    int x = bounds.x;
+    if (align == Right) {
+        x = bounds.x + bounds.width - WIDGET_CHAR_WIDTH * (int) strlen(buf);
+    }
+    LCD.WriteAt(buf, x, bounds.y);
+}
+
+
+ValueField::ValueField(int x, int y, int width, void (*format_)(char* buf, int size), Align align)
+    : Label(x, y, width, "", align) {
+    format = format_;
+}
+
+void ValueField::setFormatFunction(void (*format_)(char* buf, int size)) {
+    format = format_;
+}
+
+void ValueField::refresh() {
+    if (format == NULL) return;
+    char buf[WIDGET_TEXT_SIZE + 1];
+    (*format)(buf, sizeof(buf));
+    setText(buf);
+}
+
+
+Button::Button(int x, int y, int width, int height, const char* text_, bool border_)
+    : Widget(x, y, width, height) {
+    text = text_;
+    border = border_;
+    drawIcon = NULL;
+}
+
+void Button::setIcon(void (*drawIcon_)(int x, int y)) {
+    drawIcon = drawIcon_;
+    invalidate();
+}
+
+void Button::draw() {
+    if (border) {
+        LCD.DrawRectangle(bounds.x, bounds.y, bounds.width, bounds.height);
+    }
+
+    int textX = bounds.x + (bounds.width - WIDGET_CHAR_WIDTH * (int) strlen(text)) / 2;
+    int textY;
+    if (drawIcon != NULL) {
+        (*drawIcon)(bounds.x + 4, bounds.y);
+        textY = bounds.y + bounds.height - WIDGET_CHAR_HEIGHT - 3;
+    } else {
+        textY = bounds.y + (bounds.height - WIDGET_CHAR_HEIGHT) / 2;
+    }
+    LCD.WriteAt(text, textX, textY);
+}
+
+
+List::List(int x, int y, int width, int rows_)
+    : Widget(x, y, width, rows_ * LIST_ROW_HEIGHT) {
+    rows = rows_;
+    count = 0;
+    first = 0;
+    nameOf = NULL;
+    formatValue = NULL;
+}
+
+void List::setItems(int count_, const char* (*nameOf_)(int i), void (*formatValue_)(int i, char* buf, int size)) {
+    count = count_;
+    first = 0;
+    nameOf = nameOf_;
+    formatValue = formatValue_;
+    invalidate();
+}
+
+int List::getPage() const {
+    return first / rows;
+}
+
+int List::getPageCount() const {
+    return count > 0 ? (count + rows - 1) / rows : 1;
+}
+
+void List::setPage(int page) {
+    if (page >= getPageCount()) page = getPageCount() - 1;
+    if (page < 0) page = 0;
+    if (page * rows == first) return;
+    first = page * rows;
+    invalidate();
+}
+
+int List::itemAt(float y) const {
+    int i = first + (int) ((y - (float) bounds.y) / LIST_ROW_HEIGHT);
+    if (y < (float) bounds.y || i >= count || i >= first + rows) return -1;
+    return i;
+}
+
+void List::draw() {
+    char buf[WIDGET_TEXT_SIZE + 1];
+    for (int i = first; i < count && i < first + rows; i++) {
+        int y = bounds.y + 3 + LIST_ROW_HEIGHT*(i - first);
+        LCD.WriteAt((*nameOf)(i), bounds.x + 16, y);
+
+        if (formatValue == NULL) continue;
+        (*formatValue)(i, buf, sizeof(buf));
+        // Cut it off if it's too long
+        if (strlen(buf) > 8) {
+            strcpy(buf+5, "...");
+        }
+        LCD.WriteAt(buf, bounds.x + bounds.width - 28 - WIDGET_CHAR_WIDTH * (int) strlen(buf), y);
+    }
+}
+
+
+Canvas::Canvas(int x, int y, int width, int height)
+    : Widget(x, y, width, height) {
+    drawFunc = NULL;
+}
+
+void Canvas::setDrawFunction(void (*drawFunc_)()) {
+    drawFunc = drawFunc_;
+    invalidate();
+}
+
+void Canvas::draw() {
+    if (drawFunc != NULL) (*drawFunc)();
+}
+
+
+StripChart::StripChart(int x, int y, int width, int height, int backgroundColor_)
+    : Widget(x, y, width, height) {
+    backgroundColor = backgroundColor_;
+    signalCount = 0;
+    plotX = x + 1;
+    plotY = y + 1;
+    plotWidth = width - 2 < STRIP_CHART_MAX_WIDTH ? width - 2 : STRIP_CHART_MAX_WIDTH;
+    plotHeight = height - 2 < STRIP_CHART_NO_SAMPLE ? height - 2 : STRIP_CHART_NO_SAMPLE;
+    memset(history, STRIP_CHART_NO_SAMPLE, sizeof(history));
+    cursor = 0;
+}
+
+bool StripChart::addSignal(float (*read)(), float min, float max, int color) {
+    if (signalCount >= STRIP_CHART_MAX_SIGNALS) return false;
+    // sample() divides by the span; written this way round, a NaN bound is rejected too
+    if (!(max > min)) return false;
+    Signal& signal = signals[signalCount];
+    signal.read = read;
+    signal.min = min;
+    signal.max = max;
+    signal.color = color;
+    signalCount++;
+    return true;
+}
+
+void StripChart::sample() {
+    int col = cursor;
+    for (int i = 0; i < signalCount; i++) {
+        Signal& signal = signals[i];
+        float fraction = (signal.max - (*signal.read)()) / (signal.max - signal.min);
+        // A NaN reading fails every comparison, so it is caught by the first one
+        if (!(fraction >= 0)) fraction = 0;
+        if (fraction > 1) fraction = 1;
+        history[i][col] = (uint8_t) (fraction * (float) (plotHeight - 1) + 0.5f);
+    }
+
+    // Erase this column and the next one, which leaves a gap in front of the cursor
+    int next = col + 1 < plotWidth ? col + 1 : 0;
+    for (int i = 0; i < signalCount; i++) {
+        history[i][next] = STRIP_CHART_NO_SAMPLE;
+    }
+    if (isVisible()) {
+        LCD.SetFontColor(backgroundColor);
+        LCD.FillRectangle(plotX + col, plotY, next == 0 ? 1 : 2, plotHeight);
+        drawColumn(col);
+    }
+
+    cursor = next;
+}
+
+void StripChart::reset(int frameColor) {
+    memset(history, STRIP_CHART_NO_SAMPLE, sizeof(history));
+    cursor = 0;
+    LCD.SetFontColor(backgroundColor);
+    LCD.FillRectangle(bounds.x, bounds.y, bounds.width, bounds.height);
+    LCD.SetFontColor(frameColor);
+    draw();
+}
+
+void StripChart::draw() {
+    LCD.DrawRectangle(bounds.x, bounds.y, bounds.width, bounds.height);
+    for (int col = 0; col < plotWidth; col++) {
+        drawColumn(col);
+    }
+}
+
+// Draws each signal's sample in a column, joined to its sample in the column before
+void StripChart::drawColumn(int col) {
+    for (int i = 0; i < signalCount; i++) {
+        int y = history[i][col];
+        if (y == STRIP_CHART_NO_SAMPLE) continue;
+        int prev = col > 0 ? history[i][col - 1] : STRIP_CHART_NO_SAMPLE;
+        if (prev == STRIP_CHART_NO_SAMPLE) prev = y;
+
+        LCD.SetFontColor(signals[i].color);
+        LCD.DrawVerticalLine(plotX + col, plotY + (prev < y ? prev : y), plotY + (prev < y ? y : prev));
+    }
+}
+
+
+Screen::Screen(const int& backgroundColor_, const int& foregroundColor_)
+    : backgroundColor(backgroundColor_), foregroundColor(foregroundColor_) {
+    widgetCount = 0;
+}
+
+bool Screen::add(Widget* widget) {
+    if (widgetCount >= MAX_SCREEN_WIDGETS) return false;
+    widgets[widgetCount] = widget;
+    widgetCount++;
+    return true;
+}
+
+void Screen::paint() {
+    // A widget has to be erased if it changed or was hidden. Erasing clears its whole
+    //   rectangle, so any widget overlapping it has to be redrawn too, which may spread
+    //   further; repeat until nothing new needs redrawing.
+    bool spread = true;
+    while (spread) {
+        spread = false;
+        for (int i = 0; i < widgetCount; i++) {
+            Widget* w = widgets[i];
+            if (!w->drawn || (w->visible && !w->dirty)) continue;
+            for (int j = 0; j < widgetCount; j++) {
+                Widget* other = widgets[j];
+                if (other->visible && other->drawn && !other->dirty &&
+                    other->bounds.intersects(w->bounds)) {
+                    other->dirty = true;
+                    spread = true;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < widgetCount; i++) {
+        Widget* w = widgets[i];
+        if (w->drawn && (w->dirty || !w->visible)) {
+            erase(w->bounds);
+            w->drawn = false;
+        }
+        if (!w->visible) w->dirty = false;
+    }
+
+    for (int i = 0; i < widgetCount; i++) {
+        Widget* w = widgets[i];
+        if (!w->visible || !w->dirty) continue;
+        // Set for each widget, since some (e.g. StripChart) change it while drawing
+        LCD.SetFontColor(foregroundColor);
+        w->draw();
+        w->dirty = false;
+        w->drawn = true;
+    }
+}
+
+void Screen::redrawAll() {
+    LCD.Clear(backgroundColor);
+    for (int i = 0; i < widgetCount; i++) {
+        widgets[i]->drawn = false;
+        widgets[i]->dirty = widgets[i]->visible;
+    }
+    paint();
+}
+
+void Screen::invalidateArea(const Rect& area) {
+    erase(area);
+    for (int i = 0; i < widgetCount; i++) {
+        Widget* w = widgets[i];
+        if (w->visible && w->bounds.intersects(area)) {
+            w->dirty = true;
+        }
+    }
+}
+
+Widget* Screen::hit(float x, float y) const {
+    for (int i = widgetCount - 1; i >= 0; i--) {
+        if (widgets[i]->visible && widgets[i]->bounds.contains(x, y)) {
+            return widgets[i];
+        }
+    }
+    return NULL;
+}
+
+void Screen::erase(const Rect& area) {
+    LCD.SetFontColor(backgroundColor);
+    LCD.FillRectangle(area.x, area.y, area.width, area.height);
+}
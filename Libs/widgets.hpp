@@ -0,0 +1,280 @@
+#ifndef WIDGETS_HPP
+#define WIDGETS_HPP
+
+#include "stdint.h"
+
+#include "format.hpp"
+
+
+// Size of one character of the LCD font, in pixels
+#define WIDGET_CHAR_WIDTH 12
+#define WIDGET_CHAR_HEIGHT 17
+
+// Longest text a Label can hold
+#define WIDGET_TEXT_SIZE 32
+
+// Widgets one Screen can hold. ProteOS uses most of these.
+#define MAX_SCREEN_WIDGETS 64
+
+// Height of one List row
+#define LIST_ROW_HEIGHT 24
+
+#define STRIP_CHART_MAX_SIGNALS 3
+// Widest plot area a StripChart keeps history for; wider charts are cut off
+#define STRIP_CHART_MAX_WIDTH 318
+// Marks a StripChart column with nothing drawn in it
+#define STRIP_CHART_NO_SAMPLE 0xFF
+
+
+struct Rect {
+    int x, y, width, height;
+
+    bool contains(float px, float py) const;
+    bool intersects(const Rect& other) const;
+};
+
+
+// Something drawn on the screen that knows its own rectangle. Widgets are retained: they are
+//   created once, added to a Screen, and only redrawn by the Screen when invalidate() has been
+//   called on them (directly, or by a setter that changed what they show). The same rectangle
+//   is used for hit testing, so what is drawn and what can be touched always match.
+class Widget {
+public:
+
+    Widget(int x, int y, int width, int height);
+
+    const Rect& getBounds() const;
+
+    // Hidden widgets are erased on the next paint, and can't be touched.
+    void setVisible(bool visible);
+    bool isVisible() const;
+
+    // Marks the widget to be redrawn on the next paint.
+    void invalidate();
+
+    // Draws the widget in the current font color. Its rectangle has already been cleared to
+    //   the background, and nothing may be drawn outside it.
+    virtual void draw() = 0;
+
+
+protected:
+    Rect bounds;
+
+
+private:
+    friend class Screen;
+
+    bool visible;
+    bool dirty;
+    // Whether the widget is on the LCD right now
+    bool drawn;
+};
+
+
+// One line of text, left- or right-aligned in its rectangle. Text that doesn't fit is cut off.
+class Label : public Widget {
+public:
+
+    enum Align {
+        Left,
+        Right
+    };
+
+    Label(int x, int y, int width, const char* text = "", Align align = Left);
+
+    // Copies the text. Only invalidates the label if the text changed.
+    void setText(const char* text);
+    // Like setText(), with printf-style formatting by Format::print().
+    template <typename... Args>
+    void setFormat(const char* format, const Args&... args) {
+        setFormatList(format, FormatArgs<Args...>(args...));
+    }
+    const char* getText() const;
+
+    void draw();
+
+
+private:
+    char text[WIDGET_TEXT_SIZE + 1];
+    Align align;
+
+    void setFormatList(const char* format, FormatArgList args);
+};
+
+
+// A label whose text comes from a function, e.g. a live sensor reading. Call refresh() to ask
+//   the function again; the field is only redrawn if the text it gives back changed.
+class ValueField : public Label {
+public:
+
+    ValueField(int x, int y, int width, void (*format)(char* buf, int size), Align align = Left);
+
+    void setFormatFunction(void (*format)(char* buf, int size));
+
+    void refresh();
+
+
+private:
+    void (*format)(char* buf, int size);
+};
+
+
+// A touchable area with centered text, an optional border, and an optional icon drawn at its
+//   top left corner (the text then goes along the bottom).
+class Button : public Widget {
+public:
+
+    Button(int x, int y, int width, int height, const char* text, bool border = true);
+
+    void setIcon(void (*drawIcon)(int x, int y));
+
+    void draw();
+
+
+private:
+    const char* text;
+    bool border;
+    void (*drawIcon)(int x, int y);
+};
+
+
+// A column of rows, one per item, each with a name on the left and an optional value on the
+//   right. Items are looked up by index as they are drawn, so there can be any number of them;
+//   when there are more than fit, the list shows one page of rows at a time.
+class List : public Widget {
+public:
+
+    List(int x, int y, int width, int rows);
+
+    // Sets the items shown, and goes back to the first page. nameOf gives the name of item i.
+    //   formatValue can be NULL, or writes the value shown for item i.
+    void setItems(int count, const char* (*nameOf)(int i), void (*formatValue)(int i, char* buf, int size));
+
+    int getPage() const;
+    int getPageCount() const;
+    // Shows another page. Pages past either end are clamped to the first or last one.
+    void setPage(int page);
+
+    // The item at a touch's y position, or -1 if there is none there.
+    int itemAt(float y) const;
+
+    void draw();
+
+
+private:
+    int rows;
+    int count;
+    // The item in the top row
+    int first;
+    const char* (*nameOf)(int i);
+    void (*formatValue)(int i, char* buf, int size);
+};
+
+
+// An area drawn by a function, for content that isn't made of widgets (e.g. ProteOS reports).
+class Canvas : public Widget {
+public:
+
+    Canvas(int x, int y, int width, int height);
+
+    void setDrawFunction(void (*drawFunc)());
+
+    void draw();
+
+
+private:
+    void (*drawFunc)();
+};
+
+
+// A graph of signals over time, e.g. a light sensor or a heading error. The chart is drawn as a
+//   sweep: each sample() plots one new column at a cursor and erases the column after it, so
+//   a sample costs a few short lines however wide the chart is, and the cursor wraps back to
+//   the left edge when it reaches the right.
+//
+// A chart can be added to a Screen, which draws its frame in the font color. To use one on the
+//   debugger's screen instead, call reset() once and then Debugger::forgetScreen(), so the
+//   debugger knows to erase what the chart drew on its rows before writing there.
+class StripChart : public Widget {
+public:
+
+    StripChart(int x, int y, int width, int height, int backgroundColor = 0x000000);
+
+    // Adds a signal, which sample() gets from read() and plots from min (bottom edge) to max
+    //   (top edge) in color. Values outside that range, and NaNs, are drawn at the edge.
+    //   Returns false if the chart already has STRIP_CHART_MAX_SIGNALS, or if max isn't
+    //   greater than min.
+    bool addSignal(float (*read)(), float min, float max, int color);
+
+    // Reads every signal and draws the new column. Call this at the rate the chart should move.
+    void sample();
+
+    // Forgets every sample, then clears the chart and draws its empty frame in frameColor right
+    //   away, for charts that aren't on a Screen.
+    void reset(int frameColor);
+
+    void draw();
+
+
+private:
+    struct Signal {
+        float (*read)();
+        float min;
+        float max;
+        int color;
+    };
+
+    int backgroundColor;
+    Signal signals[STRIP_CHART_MAX_SIGNALS];
+    int signalCount;
+
+    // Plot area, inside the frame
+    int plotX, plotY, plotWidth, plotHeight;
+
+    // Each signal's y in each column, relative to plotY, or STRIP_CHART_NO_SAMPLE
+    uint8_t history[STRIP_CHART_MAX_SIGNALS][STRIP_CHART_MAX_WIDTH];
+    // The column the next sample goes in
+    int cursor;
+
+    void drawColumn(int col);
+};
+
+
+// The widgets on the LCD, and the colors they are drawn in. paint() only touches the
+//   rectangles of widgets that changed, instead of clearing the whole screen.
+class Screen {
+public:
+
+    // The colors are read every paint, so they can be changed while the screen is in use.
+    Screen(const int& backgroundColor, const int& foregroundColor);
+
+    // Adds a widget. Widgets added later are drawn over, and touched before, earlier ones.
+    bool add(Widget* widget);
+
+    // Redraws every changed widget and erases every newly hidden one. A widget that shares
+    //   pixels with one being erased is redrawn too.
+    void paint();
+
+    // Clears the whole LCD and draws every visible widget, for when something else has drawn
+    //   over the screen (e.g. the debugger).
+    void redrawAll();
+
+    // Clears an area something else drew over, and redraws the widgets in it on the next
+    //   paint.
+    void invalidateArea(const Rect& area);
+
+    // The topmost visible widget at a point, or NULL if there is none.
+    Widget* hit(float x, float y) const;
+
+
+private:
+    const int& backgroundColor;
+    const int& foregroundColor;
+
+    Widget* widgets[MAX_SCREEN_WIDGETS];
+    int widgetCount;
+
+    void erase(const Rect& area);
+};
+
+#endif
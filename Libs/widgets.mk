@@ -0,0 +1 @@
+widgets_LIBS := format
\ No newline at end of file
@@ -0,0 +1,238 @@
+// Turns the PCPROF.TXT file written by PcSampler into a list of the hottest functions.
+//
+// Usage: pcprof <Build/<app>.elf or Build/<app>.map> <PCPROF.TXT> [number of functions]
+//
+// Functions are looked up in the ELF's symbol table, or, given a .map file, in the
+//   .text.<function> sections the linker placed (every object is compiled with
+//   -ffunction-sections). The ELF gives better results, since the map doesn't list library
+//   functions that were linked from archives without their own sections.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cxxabi.h>
+
+
+struct Function {
+    uint32_t start;
+    // 0 if unknown, in which case the function is assumed to run up to the next one
+    uint32_t size;
+    std::string name;
+};
+
+struct Sample {
+    uint32_t pc;
+    uint32_t count;
+};
+
+
+static std::string demangle(const std::string& name) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name.c_str(), NULL, NULL, &status);
+    if (status != 0 || demangled == NULL) return name;
+    std::string result = demangled;
+    free(demangled);
+    return result;
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static uint32_t read16(const std::vector<uint8_t>& data, size_t offset) {
+    return (uint32_t) data[offset] | (uint32_t) data[offset + 1] << 8;
+}
+
+static uint32_t read32(const std::vector<uint8_t>& data, size_t offset) {
+    return read16(data, offset) | read16(data, offset + 2) << 16;
+}
+
+// Reads the function symbols of a little-endian 32-bit ELF file.
+static bool readElf(const char* path, std::vector<Function>* functions) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // ELF32, little-endian
+    if (data.size() < 52 || memcmp(data.data(), "\x7f" "ELF", 4) != 0 || data[4] != 1 || data[5] != 1) {
+        fprintf(stderr, "%s is not a 32-bit little-endian ELF file\n", path);
+        return false;
+    }
+
+    uint32_t sectionOffset = read32(data, 0x20);
+    uint32_t sectionSize = read16(data, 0x2E);
+    uint32_t sectionCount = read16(data, 0x30);
+    if (sectionOffset + (size_t) sectionSize * sectionCount > data.size()) return false;
+
+    for (uint32_t i = 0; i < sectionCount; i++) {
+        size_t section = sectionOffset + (size_t) i * sectionSize;
+        // SHT_SYMTAB
+        if (read32(data, section + 4) != 2) continue;
+
+        uint32_t symbolOffset = read32(data, section + 16);
+        uint32_t symbolBytes = read32(data, section + 20);
+        uint32_t stringSection = read32(data, section + 24);
+        uint32_t symbolSize = read32(data, section + 36);
+        if (stringSection >= sectionCount || symbolSize == 0) continue;
+        uint32_t stringOffset = read32(data, sectionOffset + (size_t) stringSection * sectionSize + 16);
+
+        for (uint32_t s = 0; s + symbolSize <= symbolBytes; s += symbolSize) {
+            size_t symbol = symbolOffset + s;
+            if (symbol + 16 > data.size()) break;
+            // STT_FUNC
+            if ((data[symbol + 12] & 0xF) != 2) continue;
+
+            size_t nameOffset = stringOffset + read32(data, symbol);
+            if (nameOffset >= data.size()) continue;
+
+            Function f;
+            // Thumb function symbols have bit 0 set
+            f.start = read32(data, symbol + 4) & ~1u;
+            f.size = read32(data, symbol + 8);
+            f.name = demangle((const char*) &data[nameOffset]);
+            functions->push_back(f);
+        }
+    }
+    return true;
+}
+
+// Reads the function sections out of a GNU ld map file. A section's name, address and size
+//   are on one line, unless the name is too long, in which case the rest is on the next line:
+//
+//    .text._ZN6Motors4turnEf
+//                   0x00001234       0x40 Build/Libs/navigation.o
+static bool readMap(const char* path, std::vector<Function>* functions) {
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line, pendingName;
+    while (std::getline(file, line)) {
+        std::istringstream words(line);
+        std::string first;
+        if (!(words >> first)) continue;
+
+        std::string name;
+        if (line[0] == ' ' && first.compare(0, 6, ".text.") == 0) {
+            name = first.substr(6);
+        } else if (!pendingName.empty() && first.compare(0, 2, "0x") == 0) {
+            name = pendingName;
+            words.clear();
+            words.str(line);
+        } else {
+            pendingName.clear();
+            continue;
+        }
+
+        std::string address, size;
+        if (!(words >> address >> size)) {
+            // Name on its own line
+            pendingName = name;
+            continue;
+        }
+        pendingName.clear();
+        if (address.compare(0, 2, "0x") != 0 || size.compare(0, 2, "0x") != 0) continue;
+
+        Function f;
+        f.start = (uint32_t) strtoul(address.c_str(), NULL, 16);
+        f.size = (uint32_t) strtoul(size.c_str(), NULL, 16);
+        f.name = demangle(name);
+        // Sections that were garbage collected are listed at address 0
+        if (f.start != 0 && f.size != 0) functions->push_back(f);
+    }
+    return true;
+}
+
+static bool readSamples(const char* path, std::vector<Sample>* samples, unsigned long* total,
+                        unsigned long* dropped, int* rateHz) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return false;
+
+    int version;
+    if (fscanf(file, "PCPROF %i %lu %lu %i", &version, total, dropped, rateHz) != 4 || version != 1) {
+        fprintf(stderr, "%s is not a version 1 PCPROF file\n", path);
+        fclose(file);
+        return false;
+    }
+
+    Sample s;
+    while (fscanf(file, "%x %u", &s.pc, &s.count) == 2) {
+        samples->push_back(s);
+    }
+    fclose(file);
+    return true;
+}
+
+// Finds the function containing pc, or NULL. functions must be sorted by start address.
+static const Function* findFunction(const std::vector<Function>& functions, uint32_t pc) {
+    auto after = std::upper_bound(functions.begin(), functions.end(), pc,
+                                  [](uint32_t a, const Function& f) { return a < f.start; });
+    if (after == functions.begin()) return NULL;
+    const Function& f = *(after - 1);
+    if (f.size != 0 && pc >= f.start + f.size) return NULL;
+    return &f;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <app.elf | app.map> <PCPROF.TXT> [count]\n", argv[0]);
+        return 2;
+    }
+    int shown = argc > 3 ? atoi(argv[3]) : 30;
+
+    std::vector<Function> functions;
+    bool loaded = endsWith(argv[1], ".map") ? readMap(argv[1], &functions) : readElf(argv[1], &functions);
+    if (!loaded) {
+        fprintf(stderr, "Could not read symbols from %s\n", argv[1]);
+        return 1;
+    }
+    std::sort(functions.begin(), functions.end(),
+              [](const Function& a, const Function& b) { return a.start < b.start; });
+
+    std::vector<Sample> samples;
+    unsigned long total = 0, dropped = 0;
+    int rateHz = 0;
+    if (!readSamples(argv[2], &samples, &total, &dropped, &rateHz)) {
+        fprintf(stderr, "Could not read samples from %s\n", argv[2]);
+        return 1;
+    }
+
+    std::map<std::string, unsigned long> byFunction;
+    for (const Sample& s : samples) {
+        const Function* f = findFunction(functions, s.pc);
+        if (f != NULL) {
+            byFunction[f->name] += s.count;
+        } else {
+            char unknown[32];
+            snprintf(unknown, sizeof(unknown), "?? 0x%08x", s.pc);
+            byFunction[unknown] += s.count;
+        }
+    }
+
+    std::vector<std::pair<std::string, unsigned long>> ranked(byFunction.begin(), byFunction.end());
+    std::sort(ranked.begin(), ranked.end(),
+              [](const std::pair<std::string, unsigned long>& a, const std::pair<std::string, unsigned long>& b) {
+                  return a.second > b.second;
+              });
+
+    printf("%lu samples", total);
+    if (rateHz > 0) printf(" (%.1f s at %i Hz)", (double) total / rateHz, rateHz);
+    if (dropped > 0) printf(", %lu dropped because the table was full", dropped);
+    printf("\n\n");
+    printf("%7s %8s  %s\n", "percent", "samples", "function");
+
+    unsigned long counted = total > dropped ? total - dropped : 0;
+    for (size_t i = 0; i < ranked.size() && (int) i < shown; i++) {
+        double percent = counted > 0 ? 100.0 * (double) ranked[i].second / (double) counted : 0;
+        printf("%6.2f%% %8lu  %s\n", percent, ranked[i].second, ranked[i].first.c_str());
+    }
+    return 0;
+}
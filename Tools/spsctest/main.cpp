@@ -0,0 +1,156 @@
+// Stress-tests SpscQueue and LatestValue from spsc.hpp with a producer and a consumer running
+//   on separate threads, which is a harsher test than the robot's interrupt handler and main
+//   loop: here both sides really do run at the same time.
+//
+// Usage: spsctest [number of items]
+//
+// Waiting sides yield, so the test also finishes in reasonable time on a single core, where the
+//   threads only overlap when the scheduler switches between them.
+//
+// The queue test checks that every item arrives exactly once, in order and not torn. The
+//   latest-value test checks that readers only ever see whole values, and never an older one
+//   than they saw before. Exits with status 0 if both pass.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "spsc.hpp"
+
+
+// Items are bigger than a word, so a torn copy shows up as words that don't match
+struct Item {
+    uint32_t words[8];
+};
+
+static Item makeItem(uint32_t n) {
+    Item item;
+    for (uint32_t& word : item.words) word = n;
+    return item;
+}
+
+// Returns the number every word of the item holds, or -1 if they differ
+static int64_t itemNumber(const Item& item) {
+    for (uint32_t word : item.words) {
+        if (word != item.words[0]) return -1;
+    }
+    return item.words[0];
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool testQueue(uint32_t count) {
+    // Small, so the producer keeps running into a full queue and the consumer into an empty one
+    static SpscQueue<Item, 16> queue;
+    uint32_t fullCount = 0;
+    // Set when the consumer gives up, so the producer doesn't wait forever for room
+    std::atomic<bool> failed(false);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        for (uint32_t n = 0; n < count && !failed; n++) {
+            while (!queue.push(makeItem(n)) && !failed) {
+                fullCount++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool ok = true;
+    uint32_t emptyCount = 0;
+    for (uint32_t expected = 0; expected < count; expected++) {
+        Item item;
+        while (!queue.pop(&item)) {
+            emptyCount++;
+            std::this_thread::yield();
+        }
+        int64_t n = itemNumber(item);
+        if (n != expected) {
+            if (n < 0) {
+                printf("SpscQueue: item %u was torn\n", expected);
+            } else {
+                printf("SpscQueue: expected item %u, got %lld\n", expected, (long long) n);
+            }
+            ok = false;
+            failed = true;
+            break;
+        }
+    }
+    producer.join();
+
+    if (ok && !queue.empty()) {
+        printf("SpscQueue: %u items left over\n", queue.size());
+        ok = false;
+    }
+
+    double seconds = secondsSince(start);
+    printf("SpscQueue: %u items in %.2f s (%.0f ns each), %u pushes on full, %u pops on empty: %s\n",
+           count, seconds, seconds * 1e9 / count, fullCount, emptyCount, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool testLatestValue(uint32_t count) {
+    static LatestValue<Item> value;
+    std::atomic<bool> writing(true);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread writer([&] {
+        for (uint32_t n = 1; n <= count; n++) value.write(makeItem(n));
+        writing = false;
+    });
+
+    bool ok = true;
+    uint32_t reads = 0;
+    int64_t last = 0;
+    while (ok) {
+        // Read whether the writer had finished before reading, so the last value is always seen
+        bool done = !writing;
+        Item item;
+        bool written = value.read(&item);
+        int64_t n = itemNumber(item);
+        reads++;
+
+        if (n < 0) {
+            printf("LatestValue: read a torn value\n");
+            ok = false;
+        } else if (n < last) {
+            printf("LatestValue: read %lld after %lld\n", (long long) n, (long long) last);
+            ok = false;
+        } else if (written != (n != 0)) {
+            printf("LatestValue: read() returned %i for value %lld\n", written, (long long) n);
+            ok = false;
+        }
+        last = n;
+        if (done) break;
+    }
+    writer.join();
+
+    if (ok && (last != count || value.writeCount() != count)) {
+        printf("LatestValue: last value %lld and %u writes, expected %u\n", (long long) last,
+               value.writeCount(), count);
+        ok = false;
+    }
+
+    double seconds = secondsSince(start);
+    printf("LatestValue: %u writes and %u reads in %.2f s: %s\n", count, reads, seconds,
+           ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = 10000000;
+    if (argc > 1) count = (uint32_t) strtoul(argv[1], NULL, 10);
+    if (argc > 2 || count == 0) {
+        fprintf(stderr, "Usage: %s [number of items]\n", argv[0]);
+        return 2;
+    }
+
+    bool ok = testQueue(count);
+    ok = testLatestValue(count) && ok;
+    return ok ? 0 : 1;
+}
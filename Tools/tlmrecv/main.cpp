@@ -0,0 +1,303 @@
+// Receives the frames sent by UartStream and prints each telemetry record as a CSV line.
+//
+// Usage: tlmrecv <serial device> [-b baud] [-o file.csv]
+//        tlmrecv --loopback [frames]
+//
+// --loopback checks the send and receive paths without a robot. It opens a Linux
+//   pseudo-terminal and sends frames into one end through the FrameQueue UartStream uses,
+//   drained into a ByteTransport that writes to the pseudo-terminal. Some noise goes in
+//   first, one byte of one frame is corrupted on the way, and a burst of frames overfills the
+//   queue so that some are dropped. The other end is read as if it were a serial port. Exits
+//   with status 0 if every frame the queue accepted came through whole, the corrupted one was
+//   rejected, and the queue dropped exactly the frames that didn't fit.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "frame.hpp"
+#include "framequeue.hpp"
+#include "telemetry.hpp"
+
+
+static speed_t toSpeed(int baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default: return 0;
+    }
+}
+
+// Opens a serial port (or the slave end of a pseudo-terminal) for raw 8N1 reading.
+static int openSerial(const char* path, int baud) {
+    speed_t speed = toSpeed(baud);
+    if (speed == 0) {
+        fprintf(stderr, "Unsupported baud rate %i\n", baud);
+        return -1;
+    }
+
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        fprintf(stderr, "%s is not a serial port: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 1;
+    tty.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tty);
+    return fd;
+}
+
+static void printHeader(FILE* out) {
+    fprintf(out, "time_ms,left_counts,right_counts,left_power,right_power,"
+                 "x,y,heading,rps_x,rps_y,rps_heading\n");
+}
+
+static void printRecord(FILE* out, const TelemetryRecord& r) {
+    fprintf(out, "%u,%d,%d,%.2f,%.2f,%.3f,%.3f,%.2f,%.3f,%.3f,%.2f\n", r.timeMs, r.leftCounts,
+            r.rightCounts, r.leftPower / 100.0, r.rightPower / 100.0, r.x, r.y, r.heading,
+            r.rpsX, r.rpsY, r.rpsHeading);
+}
+
+// Reads frames from fd until it closes, or until maxFrames telemetry frames have arrived (if
+//   positive) or timeoutMs passes without data (if positive). Returns how many telemetry
+//   frames were received.
+static long receive(int fd, FrameDecoder* decoder, FILE* out, FILE* record, long maxFrames, int timeoutMs) {
+    long frames = 0;
+    uint8_t buf[256];
+    while (maxFrames <= 0 || frames < maxFrames) {
+        pollfd p = { fd, POLLIN, 0 };
+        int ready = poll(&p, 1, timeoutMs > 0 ? timeoutMs : -1);
+        if (ready == 0) break;
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+
+        for (ssize_t i = 0; i < n; i++) {
+            if (!decoder->feed(buf[i])) continue;
+            if (decoder->getType() != FRAME_TYPE_TELEMETRY ||
+                decoder->getLength() != (int) sizeof(TelemetryRecord)) continue;
+
+            TelemetryRecord r;
+            memcpy(&r, decoder->getPayload(), sizeof(r));
+            if (out != NULL) printRecord(out, r);
+            if (record != NULL) printRecord(record, r);
+            frames++;
+        }
+        if (out != NULL) fflush(out);
+    }
+    return frames;
+}
+
+// The same queue size and drain rate as UartStream, so the loopback test queues and drops
+//   frames the way the robot does
+#define LOOPBACK_CAPACITY 512
+#define LOOPBACK_BYTES_PER_TICK 16
+
+// Frames sent on top of a full queue at the start of the loopback test, all of which should
+//   be dropped
+#define LOOPBACK_DROPS 5
+
+#define LOOPBACK_FRAME_SIZE ((long) sizeof(TelemetryRecord) + FRAME_OVERHEAD)
+
+// Whole frames that fit in the empty queue
+#define LOOPBACK_BURST (LOOPBACK_CAPACITY / LOOPBACK_FRAME_SIZE)
+
+// The loopback test's ByteTransport: the master end of the pseudo-terminal, and which byte
+//   written to it (counting from 0) gets corrupted
+static int loopbackMaster = -1;
+static long loopbackBytes = 0;
+static long loopbackCorruptByte = -1;
+
+static bool loopbackCanWrite() {
+    pollfd p = { loopbackMaster, POLLOUT, 0 };
+    return poll(&p, 1, 0) > 0 && (p.revents & POLLOUT) != 0;
+}
+
+static void loopbackWriteByte(uint8_t byte) {
+    if (loopbackBytes == loopbackCorruptByte) byte ^= 0xFF;
+    loopbackBytes++;
+    if (write(loopbackMaster, &byte, 1) < 0) _exit(1);
+}
+
+static const ByteTransport loopbackTransport = { &loopbackCanWrite, &loopbackWriteByte };
+
+static TelemetryRecord testRecord(long i) {
+    TelemetryRecord r;
+    memset(&r, 0, sizeof(r));
+    r.timeMs = (uint32_t) (i * 50);
+    r.leftCounts = (int32_t) (i * 3);
+    r.rightCounts = (int32_t) (i * 3 + 1);
+    r.leftPower = 4000;
+    r.rightPower = -4000;
+    r.x = 0.5f * (float) i;
+    r.y = 10;
+    r.heading = 90;
+    r.rpsX = r.x;
+    r.rpsY = r.y;
+    r.rpsHeading = r.heading;
+    return r;
+}
+
+// Drains the queue into the pseudo-terminal a tick's worth of bytes at a time, like the
+//   ticker task does, until it is empty
+template <uint32_t Capacity>
+static void drainAll(FrameQueue<Capacity>* queue) {
+    while (!queue->empty()) {
+        queue->drain(loopbackTransport, LOOPBACK_BYTES_PER_TICK);
+        usleep(100);
+    }
+}
+
+// Sends frames + 1 frames through a FrameQueue into the master end of a pseudo-terminal,
+//   with some noise in front and one byte of the middle frame corrupted. Returns false if
+//   the queue didn't accept and drop the frames it should have.
+static bool writeTestFrames(int master, long frames) {
+    loopbackMaster = master;
+    const uint8_t noise[] = { 0x00, FRAME_SYNC1, 0x13, FRAME_SYNC1, FRAME_SYNC1, 0x37 };
+    if (write(master, noise, sizeof(noise)) < 0) return false;
+
+    // One extra frame, damaged in the payload so the decoder has to reject it
+    loopbackCorruptByte = (frames / 2) * LOOPBACK_FRAME_SIZE + 10;
+
+    static FrameQueue<LOOPBACK_CAPACITY> queue;
+    bool ok = true;
+    long sent = 0;
+
+    // Overfill the empty queue: the frames that fit are sent whole, and the rest are dropped
+    for (long i = 0; i < LOOPBACK_BURST + LOOPBACK_DROPS; i++) {
+        TelemetryRecord r = testRecord(sent);
+        bool accepted = queue.send(FRAME_TYPE_TELEMETRY, &r, sizeof(r));
+        if (accepted != (i < LOOPBACK_BURST)) ok = false;
+        if (accepted) sent++;
+    }
+    if (queue.getDroppedFrames() != LOOPBACK_DROPS) ok = false;
+    drainAll(&queue);
+
+    while (sent <= frames) {
+        TelemetryRecord r = testRecord(sent);
+        if (!queue.send(FRAME_TYPE_TELEMETRY, &r, sizeof(r))) ok = false;
+        sent++;
+        drainAll(&queue);
+    }
+    if (queue.getDroppedFrames() != LOOPBACK_DROPS) ok = false;
+    return ok;
+}
+
+static int loopback(long frames) {
+    if (frames < LOOPBACK_BURST) {
+        fprintf(stderr, "--loopback needs at least %ld frames\n", LOOPBACK_BURST);
+        return 2;
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        fprintf(stderr, "Could not create a pseudo-terminal: %s\n", strerror(errno));
+        return 1;
+    }
+    std::string slavePath = ptsname(master);
+    int slave = openSerial(slavePath.c_str(), 115200);
+    if (slave < 0) return 1;
+
+    pid_t writer = fork();
+    if (writer < 0) {
+        fprintf(stderr, "fork failed: %s\n", strerror(errno));
+        return 1;
+    }
+    if (writer == 0) {
+        close(slave);
+        bool queued = writeTestFrames(master, frames);
+        // Give the reader time to drain the pty before it goes away
+        sleep(1);
+        _exit(queued ? 0 : 1);
+    }
+
+    FrameDecoder decoder;
+    long received = receive(slave, &decoder, NULL, NULL, frames, 2000);
+    int status = 0;
+    waitpid(writer, &status, 0);
+    bool queued = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    close(slave);
+    close(master);
+
+    printf("loopback over %s: sent %ld good frames and 1 bad, received %ld, rejected %u\n",
+           slavePath.c_str(), frames, received, decoder.getBadFrames());
+    printf("queue %s %i frames sent on top of a full queue\n", queued ? "dropped" : "did NOT drop",
+           LOOPBACK_DROPS);
+    bool ok = queued && received == frames && decoder.getBadFrames() == 1;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "--loopback") == 0) {
+        return loopback(argc >= 3 ? atol(argv[2]) : 100);
+    }
+
+    const char* device = NULL;
+    const char* recordPath = NULL;
+    int baud = 115200;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baud = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else {
+            device = argv[i];
+        }
+    }
+    if (device == NULL) {
+        fprintf(stderr, "usage: %s <serial device> [-b baud] [-o file.csv]\n", argv[0]);
+        fprintf(stderr, "       %s --loopback [frames]\n", argv[0]);
+        return 2;
+    }
+
+    int fd = openSerial(device, baud);
+    if (fd < 0) return 1;
+
+    FILE* record = NULL;
+    if (recordPath != NULL) {
+        record = fopen(recordPath, "w");
+        if (record == NULL) {
+            fprintf(stderr, "Could not open %s: %s\n", recordPath, strerror(errno));
+            return 1;
+        }
+        printHeader(record);
+    }
+
+    printHeader(stdout);
+    FrameDecoder decoder;
+    receive(fd, &decoder, stdout, record, 0, 0);
+
+    if (record != NULL) fclose(record);
+    close(fd);
+    fprintf(stderr, "%u bad frames\n", decoder.getBadFrames());
+    return 0;
+}